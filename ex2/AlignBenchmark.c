@@ -0,0 +1,502 @@
+//================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "align.h"
+#include "editdistance.h"
+//================================ Constants ====================================================
+#define NUMBER_OF_ARGS 5
+#define INDEX_OF_LENGTH_ARGUMENT 1
+#define INDEX_OF_COUNT_ARGUMENT 2
+#define INDEX_OF_IDENTITY_ARGUMENT 3
+#define INDEX_OF_INDEL_RATE_ARGUMENT 4
+#define FIRST_OPTIONAL_ARGUMENT_INDEX 5
+#define BASE_OF_COUNTING 10
+#define EMPTY_CHAR '\0'
+#define WRITE_MODE "w"
+#define FULL_PERCENT 100
+#define MIN_NUM_OF_SEQUENCES 2
+#define NUCLEOTIDE_LETTERS "ACGT"
+#define NUM_OF_NUCLEOTIDES 4
+#define DEFAULT_SEED 1
+#define DEFAULT_BAND 16
+#define BENCHMARK_MATCH 1
+#define BENCHMARK_MISMATCH -1
+#define BENCHMARK_GAP -2
+#define NANOSECONDS_PER_SECOND 1e9
+#define CELLS_PER_GIGA_CELL 1e9
+#define SEED_OPTION_PREFIX "--seed="
+#define BAND_OPTION_PREFIX "--band="
+#define WRITE_OPTION_PREFIX "--write="
+#define FASTA_HEADER_FORMAT ">s%d\n"
+#define FASTA_LINE_WIDTH 60
+#define NEW_LINE_CHAR '\n'
+#define ARGS_ERROR "Error of usage: AlignBenchmark <length> <count> <identity %%> <indel %%> " \
+				   "[--seed=<n>] [--band=<k>] [--write=<path>]\n"
+#define INVALID_ARGUMENT_ERROR "Error of usage: invalid argument %s\n"
+#define FILE_DOES_NOT_EXIST_ERROR "Error opening file: %s\n"
+#define ERROR_NOT_ENOUGH_MEMORY "ERROR - Not enough memory!!!"
+#define ALIGNMENT_ERROR "Error of alignment: %s\n"
+#define PRINT_SETTINGS_LINE "%d sequences of length %d, %d%% identity, %d%% indels, seed %u\n\n"
+#define PRINT_TABLE_HEADER "%-12s %8s %14s %10s %8s %12s %12s %12s\n"
+#define PRINT_TABLE_ROW "%-12s %8zu %14.0f %10.3f %8.3f %12zu %12zu %12ld\n"
+#define PAIRS_TITLE "pairs"
+#define KERNEL_TITLE "kernel"
+#define CELLS_TITLE "cells"
+#define SECONDS_TITLE "seconds"
+#define GCUPS_TITLE "GCUPS"
+#define ALLOCATIONS_TITLE "allocations"
+#define WORKSPACE_TITLE "workspace KB"
+#define PEAK_RSS_TITLE "peak RSS KB"
+#define BYTES_PER_KB 1024
+#define GLOBAL_KERNEL_NAME "global"
+#define LOCAL_KERNEL_NAME "local"
+#define SEMI_GLOBAL_KERNEL_NAME "semiglobal"
+#define BANDED_KERNEL_NAME "banded"
+#define EDIT_DISTANCE_KERNEL_NAME "myers"
+
+//================================ Code Segment =================================================
+
+/**
+ * This structure stores the values of the input arguments: the generated set, and the band of
+ * the banded kernel.
+ */
+typedef struct Settings
+{
+	int length;
+	int count;
+	int identity;
+	int indelRate;
+	unsigned int seed;
+	int band;
+	const char *fastaPath;
+} Settings;
+
+/**
+ * This structure represents a generated set of sequences, stored one after the other in one
+ * block of residues.
+ */
+typedef struct SequenceSet
+{
+	char *residues;
+	int *offsets;
+	int *sizes;
+	int count;
+} SequenceSet;
+
+/**
+ * This structure represents a kernel to benchmark: an alignment mode, and a band (or NO_BAND).
+ */
+typedef struct Kernel
+{
+	const char *name;
+	AlignmentMode mode;
+	int band;
+} Kernel;
+
+/**
+ * This function checks that a memory allocation succeeded, and exits with an error otherwise.
+ * @param p - the allocated memory.
+ */
+void nullPointerCheckerForAllocatedMemory(const void *p)
+{
+	if(p == NULL)
+	{
+		fprintf(stderr, ERROR_NOT_ENOUGH_MEMORY);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function parses a non negative integer argument, and exits with an error message if it's
+ * not one, or if it's bigger than maxValue.
+ * @param str - the argument.
+ * @param maxValue - the maximal valid value.
+ * @return the value of the argument.
+ */
+int parseNonNegativeArgument(const char *str, const int maxValue)
+{
+	char *end = NULL;
+	long value = strtol(str, &end, BASE_OF_COUNTING);
+
+	if(end == str || *end != EMPTY_CHAR || value < 0 || value > maxValue)
+	{
+		fprintf(stderr, INVALID_ARGUMENT_ERROR, str);
+		exit(EXIT_FAILURE);
+	}
+
+	return (int) value;
+}
+
+/**
+ * This function parses the input arguments.
+ * @param numOfArgs - the number of input arguments.
+ * @param args - the input arguments.
+ * @return the settings of the benchmark.
+ */
+Settings parseArguments(const int numOfArgs, char *args[])
+{
+	Settings settings = {0, 0, 0, 0, DEFAULT_SEED, DEFAULT_BAND, NULL};
+	size_t seedPrefixLen = strlen(SEED_OPTION_PREFIX);
+	size_t bandPrefixLen = strlen(BAND_OPTION_PREFIX);
+	size_t writePrefixLen = strlen(WRITE_OPTION_PREFIX);
+	int i;
+
+	if(numOfArgs < NUMBER_OF_ARGS)
+	{
+		fprintf(stderr, ARGS_ERROR);
+		exit(EXIT_FAILURE);
+	}
+
+	settings.length = parseNonNegativeArgument(args[INDEX_OF_LENGTH_ARGUMENT], INT_MAX / 2);
+	settings.count = parseNonNegativeArgument(args[INDEX_OF_COUNT_ARGUMENT], INT_MAX);
+	settings.identity = parseNonNegativeArgument(args[INDEX_OF_IDENTITY_ARGUMENT], FULL_PERCENT);
+	settings.indelRate = parseNonNegativeArgument(args[INDEX_OF_INDEL_RATE_ARGUMENT],
+												  FULL_PERCENT - settings.identity);
+
+	if(settings.count < MIN_NUM_OF_SEQUENCES)
+	{
+		fprintf(stderr, INVALID_ARGUMENT_ERROR, args[INDEX_OF_COUNT_ARGUMENT]);
+		exit(EXIT_FAILURE);
+	}
+
+	for(i = FIRST_OPTIONAL_ARGUMENT_INDEX ; i < numOfArgs ; i++)
+	{
+		if(strncmp(args[i], SEED_OPTION_PREFIX, seedPrefixLen) == 0)
+		{
+			settings.seed = (unsigned int) parseNonNegativeArgument(args[i] + seedPrefixLen,
+																	INT_MAX);
+		}
+		else if(strncmp(args[i], BAND_OPTION_PREFIX, bandPrefixLen) == 0)
+		{
+			settings.band = parseNonNegativeArgument(args[i] + bandPrefixLen, INT_MAX);
+		}
+		else if(strncmp(args[i], WRITE_OPTION_PREFIX, writePrefixLen) == 0)
+		{
+			settings.fastaPath = args[i] + writePrefixLen;
+		}
+		else
+		{
+			fprintf(stderr, INVALID_ARGUMENT_ERROR, args[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return settings;
+}
+
+/**
+ * This function returns a random nucleotide letter.
+ * @return the nucleotide.
+ */
+char randomNucleotide()
+{
+	return NUCLEOTIDE_LETTERS[rand() % NUM_OF_NUCLEOTIDES];
+}
+
+/**
+ * This function returns TRUE with a given probability.
+ * @param percent - the probability, in percent.
+ * @return TRUE or FALSE.
+ */
+int randomEvent(const int percent)
+{
+	return rand() % FULL_PERCENT < percent;
+}
+
+/**
+ * This function generates a set of sequences: every sequence is a mutated copy of one random
+ * ancestor sequence. Every residue of the ancestor is copied with probability identity%, and
+ * otherwise it's an indel with probability indelRate% (a deletion, or an insertion of a random
+ * residue before it, with equal probability) or a substitution by a random residue. With 0%
+ * identity and indels, the sequences are independent random sequences.
+ * @param settings - the settings of the set.
+ * @return the set.
+ */
+SequenceSet generateSequenceSet(const Settings *settings)
+{
+	SequenceSet set = {NULL, NULL, NULL, settings->count};
+	//a sequence is at most twice as long as its ancestor (an insertion before every residue).
+	size_t maxSize = 2 * (size_t) settings->length + 1;
+	char *ancestor = (char*) malloc((size_t) settings->length + 1);
+	int seq;
+	int pos;
+
+	set.residues = (char*) malloc(maxSize * (size_t) settings->count);
+	set.offsets = (int*) malloc((size_t) settings->count * sizeof(int));
+	set.sizes = (int*) malloc((size_t) settings->count * sizeof(int));
+	nullPointerCheckerForAllocatedMemory(ancestor);
+	nullPointerCheckerForAllocatedMemory(set.residues);
+	nullPointerCheckerForAllocatedMemory(set.offsets);
+	nullPointerCheckerForAllocatedMemory(set.sizes);
+
+	srand(settings->seed);
+
+	for(pos = 0 ; pos < settings->length ; pos++)
+	{
+		ancestor[pos] = randomNucleotide();
+	}
+
+	size_t offset = 0;
+	for(seq = 0 ; seq < settings->count ; seq++)
+	{
+		char *sequence = set.residues + offset;
+		int size = 0;
+
+		for(pos = 0 ; pos < settings->length ; pos++)
+		{
+			if(randomEvent(settings->identity))
+			{
+				sequence[size++] = ancestor[pos];
+			}
+			else if(rand() % FULL_PERCENT < settings->indelRate * FULL_PERCENT /
+											(FULL_PERCENT - settings->identity))
+			{
+				if(randomEvent(FULL_PERCENT / 2))
+				{
+					sequence[size++] = randomNucleotide();
+					sequence[size++] = ancestor[pos];
+				}
+			}
+			else
+			{
+				sequence[size++] = randomNucleotide();
+			}
+		}
+
+		set.offsets[seq] = (int) offset;
+		set.sizes[seq] = size;
+		offset += (size_t) size;
+	}
+
+	free(ancestor);
+
+	return set;
+}
+
+/**
+ * This function writes a set of sequences to a FASTA file, so it can be given to
+ * CompareSequences too.
+ * @param set - the set.
+ * @param filePath - the path of the file.
+ */
+void writeSequenceSet(const SequenceSet *set, const char *filePath)
+{
+	FILE *fp = fopen(filePath, WRITE_MODE);
+	int seq;
+	int pos;
+
+	if(fp == NULL)
+	{
+		fprintf(stderr, FILE_DOES_NOT_EXIST_ERROR, filePath);
+		exit(EXIT_FAILURE);
+	}
+
+	for(seq = 0 ; seq < set->count ; seq++)
+	{
+		fprintf(fp, FASTA_HEADER_FORMAT, seq);
+		for(pos = 0 ; pos < set->sizes[seq] ; pos += FASTA_LINE_WIDTH)
+		{
+			int lineSize = (set->sizes[seq] - pos < FASTA_LINE_WIDTH) ? set->sizes[seq] - pos :
+						   FASTA_LINE_WIDTH;
+			fwrite(set->residues + set->offsets[seq] + pos, sizeof(char), (size_t) lineSize, fp);
+			fputc(NEW_LINE_CHAR, fp);
+		}
+	}
+
+	fclose(fp);
+}
+
+/**
+ * This function returns the time of a monotonic clock, in seconds.
+ * @return the time.
+ */
+double currentSeconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + (double) now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * This function returns the peak resident set size of the process so far.
+ * @return the peak RSS, in KB.
+ */
+long peakResidentSetSize()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+/**
+ * This function prints a row of the results: the number of pairs and of cells (of the full
+ * scores matrices, so banded and full kernels are compared on equal footing), the time, the GCUPS
+ * (giga cell updates per second, 0 if no time was measured), the number of workspace allocations,
+ * the peak size of the workspace of the kernel (rounded up to KB), and the peak RSS of the process
+ * so far.
+ * @param kernelName - the name of the kernel.
+ * @param numOfPairs - the number of pairs.
+ * @param numOfCells - the number of cells.
+ * @param seconds - the time of all the pairs.
+ * @param numOfAllocations - the number of workspace allocations.
+ * @param workspaceSize - the peak size of the workspace, in bytes.
+ */
+void printResultRow(const char *kernelName, size_t numOfPairs, double numOfCells, double seconds,
+					size_t numOfAllocations, size_t workspaceSize)
+{
+	printf(PRINT_TABLE_ROW, kernelName, numOfPairs, numOfCells, seconds,
+		   (seconds > 0) ? numOfCells / CELLS_PER_GIGA_CELL / seconds : 0.0, numOfAllocations,
+		   (workspaceSize + BYTES_PER_KB - 1) / BYTES_PER_KB, peakResidentSetSize());
+}
+
+/**
+ * This function aligns all the pairs of a set by one kernel, with a new aligner, and prints a
+ * row of the results. The workspace of the aligner only grows, so its size is the memory of the
+ * kernel: a banded kernel needs only its band.
+ * @param set - the set.
+ * @param kernel - the kernel.
+ */
+void benchmarkKernel(const SequenceSet *set, const Kernel *kernel)
+{
+	Aligner* aligner = alignerAlloc(BENCHMARK_MATCH, BENCHMARK_MISMATCH, BENCHMARK_GAP);
+	nullPointerCheckerForAllocatedMemory(aligner);
+
+	Alignment alignment;
+	double numOfCells = 0;
+	int i;
+	int j;
+
+	double startTime = currentSeconds();
+
+	for(i = 0 ; i < set->count ; i++)
+	{
+		for(j = i + 1 ; j < set->count ; j++)
+		{
+			AlignStatus status = alignSequences(aligner, set->residues + set->offsets[i],
+												set->sizes[i], set->residues + set->offsets[j],
+												set->sizes[j], kernel->mode, kernel->band,
+												&alignment);
+			if(status != ALIGN_SUCCESS)
+			{
+				fprintf(stderr, ALIGNMENT_ERROR, alignStatusMessage(status));
+				exit(EXIT_FAILURE);
+			}
+			numOfCells += (double) set->sizes[i] * set->sizes[j];
+		}
+	}
+
+	double seconds = currentSeconds() - startTime;
+	AlignerStats stats = alignerStats(aligner);
+
+	printResultRow(kernel->name, stats.numOfAlignments, numOfCells, seconds,
+				   stats.numOfAllocations, stats.workspaceSize);
+
+	freeAligner(&aligner);
+}
+
+/**
+ * This function calculates the edit distances of all the pairs of a set with Myers' bit-vector
+ * kernel (editdistance.h), and prints a row of the results. The sequences are packed to 2 bits per
+ * nucleotide before the time starts, and the match bit-vectors of every sequence are built once,
+ * for all of its pairs, like in CompareSequences --edit-distance.
+ * @param set - the set.
+ */
+void benchmarkEditDistance(const SequenceSet *set)
+{
+	size_t *packedOffsets = (size_t*) malloc((size_t) set->count * sizeof(size_t));
+	nullPointerCheckerForAllocatedMemory(packedOffsets);
+	size_t numOfWords = 0;
+	int maxSize = 0;
+	int i;
+	int j;
+
+	for(i = 0 ; i < set->count ; i++)
+	{
+		packedOffsets[i] = numOfWords;
+		numOfWords += packedDnaSize(set->sizes[i]);
+		maxSize = (set->sizes[i] > maxSize) ? set->sizes[i] : maxSize;
+	}
+
+	uint64_t *packedResidues = (uint64_t*) malloc((numOfWords + 1) * sizeof(uint64_t));
+	nullPointerCheckerForAllocatedMemory(packedResidues);
+	for(i = 0 ; i < set->count ; i++)
+	{
+		packDnaString(set->residues + set->offsets[i], set->sizes[i],
+					  packedResidues + packedOffsets[i]);
+	}
+
+	EditDistanceQuery* query = editDistanceQueryAlloc(maxSize);
+	nullPointerCheckerForAllocatedMemory(query);
+
+	double numOfCells = 0;
+	size_t numOfPairs = 0;
+
+	double startTime = currentSeconds();
+
+	for(i = 0 ; i < set->count ; i++)
+	{
+		setEditDistanceQuery(query, packedResidues + packedOffsets[i], set->sizes[i]);
+		for(j = i + 1 ; j < set->count ; j++)
+		{
+			calculateEditDistance(query, packedResidues + packedOffsets[j], set->sizes[j]);
+			numOfCells += (double) set->sizes[i] * set->sizes[j];
+			numOfPairs++;
+		}
+	}
+
+	double seconds = currentSeconds() - startTime;
+
+	printResultRow(EDIT_DISTANCE_KERNEL_NAME, numOfPairs, numOfCells, seconds, 1,
+				   editDistanceQuerySize(query));
+
+	freeEditDistanceQuery(&query);
+	free(packedResidues);
+	free(packedOffsets);
+}
+
+/**
+ * This is the main function of the benchmark. It generates a set of sequences by the input
+ * arguments, and benchmarks every kernel of the alignment library on all of its pairs: the
+ * alignment modes, the banded global alignment and Myers' edit distance.
+ * @param argc arguments counter.
+ * @param argv arguments values.
+ * @return 0 if succeeds, 1 otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	Settings settings = parseArguments(argc, argv);
+	SequenceSet set = generateSequenceSet(&settings);
+
+	if(settings.fastaPath != NULL)
+	{
+		writeSequenceSet(&set, settings.fastaPath);
+	}
+
+	Kernel kernels[] = {{GLOBAL_KERNEL_NAME, GLOBAL_ALIGNMENT, NO_BAND},
+						{LOCAL_KERNEL_NAME, LOCAL_ALIGNMENT, NO_BAND},
+						{SEMI_GLOBAL_KERNEL_NAME, SEMI_GLOBAL_ALIGNMENT, NO_BAND},
+						{BANDED_KERNEL_NAME, GLOBAL_ALIGNMENT, settings.band}};
+	size_t k;
+
+	printf(PRINT_SETTINGS_LINE, settings.count, settings.length, settings.identity,
+		   settings.indelRate, settings.seed);
+	printf(PRINT_TABLE_HEADER, KERNEL_TITLE, PAIRS_TITLE, CELLS_TITLE, SECONDS_TITLE, GCUPS_TITLE,
+		   ALLOCATIONS_TITLE, WORKSPACE_TITLE, PEAK_RSS_TITLE);
+
+	for(k = 0 ; k < sizeof(kernels) / sizeof(kernels[0]) ; k++)
+	{
+		benchmarkKernel(&set, &kernels[k]);
+	}
+	benchmarkEditDistance(&set);
+
+	free(set.residues);
+	free(set.offsets);
+	free(set.sizes);
+
+	return 0;
+}
@@ -1,16 +1,25 @@
 //================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <math.h>
 #include <ctype.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+#include "align.h"
+#include "msa.h"
+#include "editdistance.h"
 //================================ Constants ====================================================
 #define NUMBER_OF_ARGS 5
 #define MIN_NUM_OF_SEQUENCES 2
-#define MAX_SIZE_OF_LINE 101
-#define MAX_NUM_OF_SEQUENCES 100
-#define INDEX_OF_FIRST_ROW_OR_COLUMN 0
 #define INDEX_OF_FILE_PATH_ARGUMENT 1
 #define INDEX_OF_MATCH_ARGUMENT 2
 #define INDEX_OF_MISMATCH_ARGUMENT 3
@@ -19,59 +28,272 @@
 #define TRUE 1
 #define FALSE 0
 #define FIRST_CHAR_OF_HEADER_LINE '>'
+#define NEW_LINE_CHAR '\n'
+#define READ_BUFFER_SIZE 65536
+#define INITIAL_ARENA_CAPACITY 4096
+#define INITIAL_NUM_OF_SEQUENCES 16
+#define GROWTH_FACTOR 2
+#define CARRIAGE_RETURN_CHAR '\r'
+#define WRITE_MODE "w"
+#define INDEX_OPTION "--index"
+#define SELECT_OPTION_PREFIX "--select="
+#define SELECTED_NAMES_SEPARATOR ","
+#define INDEX_FILE_SUFFIX ".fai"
+#define INDEX_LINE_FORMAT "%s\t%llu\t%llu\t%llu\t%llu\n"
+#define INDEX_HEADER_FORMAT "#%llu\t%lld\t%ld\n"
+#define INDEX_HEADER_CHAR '#'
+#define NUM_OF_INDEX_HEADER_FIELDS 3
+#define INDEX_SEPARATORS "\t\r\n"
+#define NOT_FOUND -1
+#define INVALID_LINES_FOR_INDEX_ERROR "Error indexing file %s: lines of a sequence have different " \
+									  "lengths\n"
+#define INVALID_INDEX_FILE_ERROR "Error in index file %s\n"
+#define EDIT_DISTANCE_OPTION "--edit-distance"
+#define INVALID_EDIT_DISTANCE_ERROR "Error of usage: --edit-distance needs global mode with unit " \
+									"cost scores (m = 0, s = -1, g = -1), and can't be used " \
+									"with --prefilter or --cigar\n"
+#define NOT_DNA_SEQUENCE_ERROR "Error of usage: sequence %s is not a DNA sequence\n"
+#define PRINT_EDIT_DISTANCE_LINE "Edit distance of %s to %s is %d\n"
+#define UNIT_COST_MATCH 0
+#define UNIT_COST_MISMATCH -1
+#define UNIT_COST_GAP -1
+#define PREFILTER_OPTION_PREFIX "--prefilter="
+#define PREFILTER_SEPARATOR ','
+#define NO_PREFILTER 0
+#define FULL_SIMILARITY 100
+#define INVALID_PREFILTER_ERROR "Error of usage: the prefilter must be --prefilter=<k>,<percent> " \
+								"with k > 0 and 0 <= percent <= 100\n"
+#define PRINT_SKIPPED_PAIR_LINE "Skipped alignment of %s to %s (estimated similarity %d%%)\n"
+#define SKETCH_SIZE 128
+#define ROLLING_HASH_RADIX 0x100000001b3ULL
+#define HASH_MIX_MULTIPLIER_1 0xbf58476d1ce4e5b9ULL
+#define HASH_MIX_MULTIPLIER_2 0x94d049bb133111ebULL
+#define CIGAR_OPTION "--cigar"
+#define PRINT_CIGAR_RESULT_LINE "Score for alignment of %s to %s is %d\n\nCIGAR: "
+#define OUTPUT_FLUSH_SIZE (1 << 20)
+#define STATS_OPTION "--stats"
+#define PRINT_STATS_LINE "Aligned %zu pairs with %zu workspace allocations (workspace of %zu bytes)\n"
+#define MSA_OPTION "--msa"
+#define THREADS_OPTION_PREFIX "--threads="
+#define INVALID_MSA_ERROR "Error of usage: --msa can't be used with --edit-distance or --prefilter\n"
+#define INVALID_THREADS_ERROR "Error of usage: the number of threads must be a positive integer\n"
+#define PRINT_ALIGNED_SEQUENCE_LINE ">%s\n%s\n"
+#define CHECKPOINT_OPTION_PREFIX "--checkpoint="
+#define RESUME_OPTION "--resume"
+#define CHECKPOINT_MAGIC "CSCKPT01"
+#define CHECKPOINT_MAGIC_SIZE 8
+#define CHECKPOINT_FLUSH_SIZE (4096 * sizeof(CheckpointRecord))
+#define CHECKPOINT_INTERVAL_SECONDS 5
+#define FINGERPRINT_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define BITS_PER_COMPLETED_WORD 64
+#define READ_BINARY_MODE "rb"
+#define WRITE_BINARY_MODE "wb"
+#define APPEND_BINARY_MODE "ab"
+#define INVALID_CHECKPOINT_OPTIONS_ERROR "Error of usage: --resume needs --checkpoint=<path>, and " \
+										 "they can't be used with --edit-distance or --msa\n"
+#define INVALID_CHECKPOINT_FILE_ERROR "Error in checkpoint file %s: it's not a checkpoint of " \
+									  "this input file with these scores\n"
+#define CHECKPOINT_WRITE_ERROR "Error writing checkpoint file %s\n"
+#define PRINT_RESUMED_LINE "Resumed %zu aligned pairs from checkpoint file %s\n"
+#define OUTPUT_OPTION_PREFIX "--output="
+#define ALIGNMENTS_OUTPUT_NAME "alignments"
+#define SCORES_OUTPUT_NAME "scores"
+#define PHYLIP_OUTPUT_NAME "phylip"
+#define INVALID_OUTPUT_ERROR "Error of usage: the output must be --output=alignments|scores|phylip, " \
+							 "a score matrix can't be used with --msa, --edit-distance, " \
+							 "--shard or --checkpoint, and a phylip one can't be used with " \
+							 "--prefilter\n"
+#define SCORE_MATRIX_MAGIC "CSSCORE1"
+#define SCORE_MATRIX_MAGIC_SIZE 8
+#define SKIPPED_PAIR_SCORE INT32_MIN
+#define PHYLIP_NUM_OF_SEQUENCES_LINE "%5d\n"
+#define PHYLIP_NAME_FORMAT "%-10.10s"
+#define PHYLIP_DISTANCE_FORMAT " %.1f"
+#define NEW_LINE_STRING "\n"
+#define SHARD_OPTION_PREFIX "--shard="
+#define SHARD_SEPARATOR '/'
+#define NO_SHARDS 0
+#define SHARD_HEADER_LINE "# shard %d/%d\n"
+#define INVALID_SHARD_ERROR "Error of usage: the shard must be --shard=<k>/<N> with 1 <= k <= N, " \
+							"and can't be used with --edit-distance or --msa\n"
+#define SEQUENCE_NOT_FOUND_ERROR "Error of usage: sequence %.*s was not found in file %s\n"
 #define EMPTY_CHAR '\0'
 #define READ_MODE "r"
-#define ARGS_ERROR "Error of usage: CompareSequences <path_to_sequences_file> <m> <s> <g> ...\n"
+#define ARGS_ERROR "Error of usage: CompareSequences <path_to_sequences_file> <m> <s> <g> " \
+				   "[--mode=global|local|semiglobal] [--matrix=<path>] [--band=<k>] " \
+				   "[--index] [--select=<name>,<name>...] [--edit-distance] " \
+				   "[--prefilter=<k>,<percent>] [--cigar] [--stats] [--msa] " \
+				   "[--threads=<n>] [--checkpoint=<path> [--resume]] [--shard=<k>/<N>] " \
+				   "[--output=alignments|scores|phylip] ...\n"
 #define FILE_DOES_NOT_EXIST_ERROR "Error opening file: %s\n"
 #define INVALID_INTEGER_FORMAT_ERROR_MESSAGE "Error in input argument conversion %s!\n"
 #define NO_SEQUENCES_ERROR_MESSAGE "Error of usage: %d (< 2) sequences were found in file %s\n"
 #define ERROR_NOT_ENOUGH_MEMORY "ERROR - Not enough memory!!!"
 #define PRINT_RESULT_LINE "Score for alignment of %s to %s is %d\n\nSolution:\n\n"
-#define TYPE_OF_MATCH 'm'
-#define TYPE_OF_MISMATCH 's'
-#define TYPE_OF_GAP_IN_STR1 '1'
-#define TYPE_OF_GAP_IN_STR2 '2'
-#define TYPE_OF_FIRST_CELL 'f'
 #define TWO_NEW_LINES "\n\n"
 #define ZERO_CHAR '0'
 #define NINE_CHAR '9'
 #define SEPARATOR_CHAR_FOR_GAP '-'
 #define MINUS_CHAR '-'
-#define EMPTY_SEQUENCE {0, "", ""}
+#define FIRST_OPTIONAL_ARGUMENT_INDEX 5
+#define MODE_OPTION_PREFIX "--mode="
+#define GLOBAL_MODE_NAME "global"
+#define LOCAL_MODE_NAME "local"
+#define SEMI_GLOBAL_MODE_NAME "semiglobal"
+#define UNKNOWN_OPTION_ERROR "Error of usage: unknown option %s\n"
+#define MATRIX_OPTION_PREFIX "--matrix="
+#define INVALID_MATRIX_FILE_ERROR "Error in substitution matrix file %s\n"
+#define ALIGNMENT_ERROR "Error of alignment: %s\n"
+#define BAND_OPTION_PREFIX "--band="
+#define INVALID_BAND_ERROR "Error of usage: the band must be a non negative integer, and can be " \
+						   "used only in global mode\n"
 
 //================================ Code Segment =================================================
 
 /**
- * This is a global static variable char array which keeps track of the way we are doing from the
- * last cell of score matrix to the first cell of it, in order to decode later the match
- * restoration.
+ * This enum represents the output formats: the alignments of all the pairs, or the score matrix,
+ * as packed binary scores or as a PHYLIP distance matrix.
  */
-static char *gMatchRestorationDecoder = NULL;
+typedef enum OutputFormat
+{
+	ALIGNMENTS_OUTPUT,
+	SCORES_OUTPUT,
+	PHYLIP_OUTPUT
+} OutputFormat;
 
+/**
+ * This structure stores the values of the optional input arguments.
+ */
+typedef struct Options
+{
+	AlignmentMode mode;
+	const char *matrixPath;
+	int band;
+	int useIndex;
+	const char *selectedNames;
+	int editDistance;
+	int prefilterK;
+	int prefilterThreshold;
+	int printCigar;
+	int printStats;
+	int multipleAlignment;
+	int numOfThreads;
+	const char *checkpointPath;
+	int resume;
+	int shard;
+	int numOfShards;
+	OutputFormat outputFormat;
+} Options;
 
 /**
  * this structure is for a sequence, which includes the size of its string value, the string value
- * itself and the sequence's name.
+ * itself and the sequence's name. The name and the value are stored in the names arena and the
+ * residues arena, at the given offsets.
  */
 typedef struct Sequence
 {
 	unsigned int sizeOfValue;
-	char name[MAX_SIZE_OF_LINE];
+	size_t nameOffset;
+	size_t valueOffset;
+	char *name;
 	char *value;
 } Sequence;
 
 /**
- * This structure represents a cell in the scores matrix, which has a pointer to the best cell it
- * came from in the calculation of the maximum value from 3 adjacent previous cells, the type of
- * the previous cell, and the integer value of the cell itself.
+ * This structure represents an arena: a single growing block of bytes, which stores the strings
+ * of all the sequences one after the other.
+ */
+typedef struct Arena
+{
+	char *bytes;
+	size_t size;
+	size_t capacity;
+} Arena;
+
+/**
+ * This enum represents the states of the input file parser, according to the part of the line it
+ * reads.
+ */
+typedef enum ParserState
+{
+	AT_LINE_START,
+	IN_HEADER_NAME,
+	IN_HEADER_REST,
+	IN_SEQUENCE_LINE
+} ParserState;
+
+/**
+ * This structure represents the index record of a sequence in the input file: the offset of its
+ * name in the index names arena, its number of bases, the byte offset of its first base in the
+ * file, and the number of bases and of bytes (with the end of line chars) in each of its lines.
+ */
+typedef struct IndexRecord
+{
+	size_t nameOffset;
+	size_t length;
+	size_t offset;
+	size_t lineBases;
+	size_t lineWidth;
+} IndexRecord;
+
+/**
+ * This structure represents a posting in the k-mers index: a hash value of a k-mer in the sketch
+ * of a sequence.
  */
-typedef struct CellOfScoresMatrix
+typedef struct KmerPosting
 {
-	char typeOfPrevCellPointer;
-	struct CellOfScoresMatrix *prevCellPointer;
-	int value;
-} CellOfScoresMatrix;
+	uint64_t hash;
+	int sequence;
+} KmerPosting;
 
+/**
+ * This structure stores the k-mers sketches of all the sequences (SKETCH_SIZE hash values for
+ * every sequence, of which sizes[i] are used by sequence i), and the index of all of them.
+ */
+typedef struct KmerSketches
+{
+	uint64_t *hashes;
+	int *sizes;
+	KmerPosting *postings;
+	size_t numOfPostings;
+} KmerSketches;
+
+/**
+ * This structure represents the header of a binary score matrix output. It's followed by the
+ * names table (for every sequence, the size of its name as a uint32 and then the name, with no
+ * null terminator), and then the upper triangle of the score matrix with its diagonal, row after
+ * row, as int32 scores (SKIPPED_PAIR_SCORE for pairs skipped by the prefilter). All the numbers
+ * are in the byte order of the machine which wrote them.
+ */
+typedef struct ScoreMatrixHeader
+{
+	char magic[SCORE_MATRIX_MAGIC_SIZE];
+	uint32_t numOfSequences;
+	uint32_t reserved;
+} ScoreMatrixHeader;
+
+/**
+ * This structure represents the header of a checkpoint file, which identifies the run it belongs
+ * to: the number of sequences, and a fingerprint of the residues, the scores and the mode.
+ */
+typedef struct CheckpointHeader
+{
+	char magic[CHECKPOINT_MAGIC_SIZE];
+	uint32_t numOfSequences;
+	uint32_t reserved;
+	uint64_t fingerprint;
+} CheckpointHeader;
+
+/**
+ * This structure represents a record of a checkpoint file: a pair whose result was written to
+ * stdout, and its score. The records are appended to the file after the header, 12 bytes each.
+ */
+typedef struct CheckpointRecord
+{
+	uint32_t str1Location;
+	uint32_t str2Location;
+	int32_t score;
+} CheckpointRecord;
 
 /**
  * This is a global static variable integer which stores the number of all sequences we found in
@@ -85,6 +307,54 @@ static int gNumOfSequences = 0;
  */
 static Sequence *gSequencesArray = NULL;
 
+/**
+ * This is a global static variable integer which stores the number of sequences the sequences
+ * array has room for.
+ */
+static int gSequencesCapacity = 0;
+
+/**
+ * These are global static variable arenas which store the residues and the names of all the
+ * sequences, each one null terminated.
+ */
+static Arena gResiduesArena = {NULL, 0, 0};
+static Arena gNamesArena = {NULL, 0, 0};
+
+/**
+ * This is a global static variable arena which stores the output until it's written to stdout in
+ * one large write.
+ */
+static Arena gOutputBuffer = {NULL, 0, 0};
+
+/**
+ * These are global static variables which store the checkpoint file (NULL if there's none), its
+ * path, the records of the pairs which weren't appended to it yet, the time they were last
+ * appended, a bit for every pair which was completed by a previous run (by its index in the upper
+ * triangle of pairs), and the number of those pairs.
+ */
+static FILE *gCheckpointFile = NULL;
+static const char *gCheckpointPath = NULL;
+static Arena gPendingCheckpointRecords = {NULL, 0, 0};
+static time_t gLastCheckpointTime = 0;
+static uint64_t *gCompletedPairs = NULL;
+static size_t gNumOfResumedPairs = 0;
+
+/**
+ * These are global static variables which store the range of pairs (by their indices in the upper
+ * triangle of pairs) this process aligns: all of them, unless it runs one shard of the pairs.
+ */
+static size_t gFirstPairOfShard = 0;
+static size_t gEndPairOfShard = SIZE_MAX;
+
+/**
+ * These are global static variables which store the index records of all the sequences in the
+ * input file, and their names.
+ */
+static IndexRecord *gIndexRecords = NULL;
+static int gNumOfIndexRecords = 0;
+static int gIndexRecordsCapacity = 0;
+static Arena gIndexNamesArena = {NULL, 0, 0};
+
 
 /**
  * This function returns weather or not the input string is in an integer format.
@@ -129,50 +399,327 @@ void checkNotEnoughSequences(const int numOfSequences, const char filePath[])
 }
 
 /**
- * This function calculates the maximum integer from three input integers x, y, z.
- * @param x - integer 1.
- * @param y - integer 2.
- * @param z - integer 3.
- * @return the maximum of the three.
+ * This function checks if we have at least the number of the mandatory input arguments.
+ * @param numOfArgs - the number of input arguments.
  */
-int maxOfThreeCalculator(const int x, const int y, const int z)
+void checkNumOfInputArgs(const int numOfArgs)
 {
-	if(x > y)
+	if(numOfArgs < NUMBER_OF_ARGS)
 	{
-		if(x > z)
-		{
-			return x;
-		}
-		else
-		{
-			return z;
-		}
+		fprintf(stderr, ARGS_ERROR);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function exits with an error message if the band option is not valid.
+ * @param isValid - TRUE if the band option is valid, FALSE otherwise.
+ */
+void checkValidBand(const int isValid)
+{
+	if(!isValid)
+	{
+		fprintf(stderr, INVALID_BAND_ERROR);
+		exit(EXIT_FAILURE);
+	}
+}
 
+/**
+ * This function exits with an error message if the edit distance option is used with any other
+ * scores than the unit cost ones, or with other modes or scores options, or with the prefilter
+ * or the CIGAR options (which it doesn't use).
+ * @param options - the values of the optional arguments.
+ * @param match - the score for match argument.
+ * @param mismatch - the score for mismatch argument.
+ * @param gap - the score for gap argument.
+ */
+void checkValidEditDistance(const Options options, const int match, const int mismatch,
+							const int gap)
+{
+	if(match != UNIT_COST_MATCH || mismatch != UNIT_COST_MISMATCH || gap != UNIT_COST_GAP ||
+	   options.mode != GLOBAL_ALIGNMENT || options.matrixPath != NULL || options.band != NO_BAND ||
+	   options.prefilterK != NO_PREFILTER || options.printCigar)
+	{
+		fprintf(stderr, INVALID_EDIT_DISTANCE_ERROR);
+		exit(EXIT_FAILURE);
 	}
-	else
+}
+
+/**
+ * This function parses the value of the prefilter option: the length of the k-mers and the
+ * minimal estimated similarity percentage of the pairs to align, separated by a comma.
+ * @param value - the value of the option.
+ * @param options - the options to update.
+ */
+void parsePrefilterOption(const char *value, Options *options)
+{
+	char *end = NULL;
+	long k = strtol(value, &end, BASE_OF_COUNTING);
+	long threshold = -1;
+
+	if(end != value && *end == PREFILTER_SEPARATOR)
 	{
-		if(y > z)
+		const char *thresholdStart = end + 1;
+		threshold = strtol(thresholdStart, &end, BASE_OF_COUNTING);
+		if(end == thresholdStart || *end != EMPTY_CHAR)
 		{
-			return y;
+			threshold = -1;
 		}
-		else
+	}
+
+	if(k <= 0 || k > INT_MAX || threshold < 0 || threshold > FULL_SIMILARITY)
+	{
+		fprintf(stderr, INVALID_PREFILTER_ERROR);
+		exit(EXIT_FAILURE);
+	}
+
+	options->prefilterK = (int) k;
+	options->prefilterThreshold = (int) threshold;
+}
+
+/**
+ * This function exits with an error message if the multiple alignment option is used with the
+ * edit distance or the prefilter options (which don't give the scores of all the pairs).
+ * @param options - the values of the optional arguments.
+ */
+void checkValidMultipleAlignment(const Options options)
+{
+	if(options.multipleAlignment && (options.editDistance || options.prefilterK != NO_PREFILTER))
+	{
+		fprintf(stderr, INVALID_MSA_ERROR);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function exits with an error message if the checkpoint options are not valid: resuming
+ * needs a checkpoint file, and checkpoints are only for the alignments of all the pairs.
+ * @param options - the values of the optional arguments.
+ */
+void checkValidCheckpoint(const Options options)
+{
+	if((options.resume && options.checkpointPath == NULL) ||
+	   (options.checkpointPath != NULL && (options.editDistance || options.multipleAlignment)))
+	{
+		fprintf(stderr, INVALID_CHECKPOINT_OPTIONS_ERROR);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function parses the value of the shard option: the shard and the number of shards,
+ * separated by a slash.
+ * @param value - the value of the option.
+ * @param options - the options to update.
+ */
+void parseShardOption(const char *value, Options *options)
+{
+	char *end = NULL;
+	long shard = strtol(value, &end, BASE_OF_COUNTING);
+	long numOfShards = NO_SHARDS;
+
+	if(end != value && *end == SHARD_SEPARATOR)
+	{
+		const char *numOfShardsStart = end + 1;
+		numOfShards = strtol(numOfShardsStart, &end, BASE_OF_COUNTING);
+		if(end == numOfShardsStart || *end != EMPTY_CHAR)
 		{
-			return z;
+			numOfShards = NO_SHARDS;
 		}
 	}
+
+	if(numOfShards <= NO_SHARDS || numOfShards > INT_MAX || shard < 1 || shard > numOfShards)
+	{
+		fprintf(stderr, INVALID_SHARD_ERROR);
+		exit(EXIT_FAILURE);
+	}
+
+	options->shard = (int) shard;
+	options->numOfShards = (int) numOfShards;
+}
+
+/**
+ * This function parses the value of the output option.
+ * @param value - the value of the option.
+ * @return the output format.
+ */
+OutputFormat parseOutputFormat(const char *value)
+{
+	if(strcmp(value, SCORES_OUTPUT_NAME) == 0)
+	{
+		return SCORES_OUTPUT;
+	}
+	if(strcmp(value, PHYLIP_OUTPUT_NAME) == 0)
+	{
+		return PHYLIP_OUTPUT;
+	}
+	if(strcmp(value, ALIGNMENTS_OUTPUT_NAME) != 0)
+	{
+		fprintf(stderr, INVALID_OUTPUT_ERROR);
+		exit(EXIT_FAILURE);
+	}
+	return ALIGNMENTS_OUTPUT;
+}
+
+/**
+ * This function exits with an error message if a score matrix output is used with options which
+ * don't print the scores of all the pairs in order, or if a PHYLIP one is used with the prefilter
+ * (PHYLIP has no value for a pair which wasn't aligned). A checkpoint can't be used either: after
+ * a crash, a resumed run may print the last scores again, which would shift the matrix.
+ * @param options - the values of the optional arguments.
+ */
+void checkValidOutputFormat(const Options options)
+{
+	if(options.outputFormat != ALIGNMENTS_OUTPUT &&
+	   (options.multipleAlignment || options.editDistance || options.numOfShards != NO_SHARDS ||
+		options.checkpointPath != NULL ||
+		(options.outputFormat == PHYLIP_OUTPUT && options.prefilterK != NO_PREFILTER)))
+	{
+		fprintf(stderr, INVALID_OUTPUT_ERROR);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function parses the number of threads option.
+ * @param value - the value of the option.
+ * @return the number of threads.
+ */
+int parseNumOfThreads(const char *value)
+{
+	char *end = NULL;
+	long numOfThreads = strtol(value, &end, BASE_OF_COUNTING);
+
+	if(end == value || *end != EMPTY_CHAR || numOfThreads <= 0 || numOfThreads > INT_MAX)
+	{
+		fprintf(stderr, INVALID_THREADS_ERROR);
+		exit(EXIT_FAILURE);
+	}
+
+	return (int) numOfThreads;
 }
 
 /**
- * This function checks if we have the right number of input arguments.
+ * This function parses the optional input arguments, which come after the mandatory ones.
  * @param numOfArgs - the number of input arguments.
+ * @param args - the input arguments.
+ * @return the values of the optional arguments (global alignment and no substitution matrix if
+ *         none were given).
  */
-void checkNumOfInputArgs(const int numOfArgs)
+Options parseOptionalArguments(const int numOfArgs, char *args[])
 {
-	if(numOfArgs != NUMBER_OF_ARGS)
+	Options options = {GLOBAL_ALIGNMENT, NULL, NO_BAND, FALSE, NULL, FALSE, NO_PREFILTER, 0,
+					   FALSE, FALSE, FALSE, (int) sysconf(_SC_NPROCESSORS_ONLN), NULL, FALSE,
+					   1, NO_SHARDS, ALIGNMENTS_OUTPUT};
+	size_t modePrefixLen = strlen(MODE_OPTION_PREFIX);
+	size_t matrixPrefixLen = strlen(MATRIX_OPTION_PREFIX);
+	size_t bandPrefixLen = strlen(BAND_OPTION_PREFIX);
+	size_t selectPrefixLen = strlen(SELECT_OPTION_PREFIX);
+	size_t prefilterPrefixLen = strlen(PREFILTER_OPTION_PREFIX);
+	size_t threadsPrefixLen = strlen(THREADS_OPTION_PREFIX);
+	size_t checkpointPrefixLen = strlen(CHECKPOINT_OPTION_PREFIX);
+	size_t shardPrefixLen = strlen(SHARD_OPTION_PREFIX);
+	size_t outputPrefixLen = strlen(OUTPUT_OPTION_PREFIX);
+	int i;
+
+	for(i = FIRST_OPTIONAL_ARGUMENT_INDEX ; i < numOfArgs ; i++)
 	{
-		fprintf(stderr, ARGS_ERROR);
+		if(strncmp(args[i], MODE_OPTION_PREFIX, modePrefixLen) == 0 &&
+		   strcmp(args[i] + modePrefixLen, GLOBAL_MODE_NAME) == 0)
+		{
+			options.mode = GLOBAL_ALIGNMENT;
+		}
+		else if(strncmp(args[i], MODE_OPTION_PREFIX, modePrefixLen) == 0 &&
+				strcmp(args[i] + modePrefixLen, LOCAL_MODE_NAME) == 0)
+		{
+			options.mode = LOCAL_ALIGNMENT;
+		}
+		else if(strncmp(args[i], MODE_OPTION_PREFIX, modePrefixLen) == 0 &&
+				strcmp(args[i] + modePrefixLen, SEMI_GLOBAL_MODE_NAME) == 0)
+		{
+			options.mode = SEMI_GLOBAL_ALIGNMENT;
+		}
+		else if(strncmp(args[i], MATRIX_OPTION_PREFIX, matrixPrefixLen) == 0)
+		{
+			options.matrixPath = args[i] + matrixPrefixLen;
+		}
+		else if(strncmp(args[i], BAND_OPTION_PREFIX, bandPrefixLen) == 0)
+		{
+			checkIfInteger(args[i] + bandPrefixLen);
+			options.band = (int) strtol(args[i] + bandPrefixLen, NULL, BASE_OF_COUNTING);
+			checkValidBand(options.band >= 0);
+		}
+		else if(strcmp(args[i], INDEX_OPTION) == 0)
+		{
+			options.useIndex = TRUE;
+		}
+		else if(strncmp(args[i], SELECT_OPTION_PREFIX, selectPrefixLen) == 0)
+		{
+			options.useIndex = TRUE;
+			options.selectedNames = args[i] + selectPrefixLen;
+		}
+		else if(strcmp(args[i], EDIT_DISTANCE_OPTION) == 0)
+		{
+			options.editDistance = TRUE;
+		}
+		else if(strcmp(args[i], CIGAR_OPTION) == 0)
+		{
+			options.printCigar = TRUE;
+		}
+		else if(strcmp(args[i], STATS_OPTION) == 0)
+		{
+			options.printStats = TRUE;
+		}
+		else if(strncmp(args[i], PREFILTER_OPTION_PREFIX, prefilterPrefixLen) == 0)
+		{
+			parsePrefilterOption(args[i] + prefilterPrefixLen, &options);
+		}
+		else if(strcmp(args[i], MSA_OPTION) == 0)
+		{
+			options.multipleAlignment = TRUE;
+		}
+		else if(strncmp(args[i], THREADS_OPTION_PREFIX, threadsPrefixLen) == 0)
+		{
+			options.numOfThreads = parseNumOfThreads(args[i] + threadsPrefixLen);
+		}
+		else if(strncmp(args[i], CHECKPOINT_OPTION_PREFIX, checkpointPrefixLen) == 0)
+		{
+			options.checkpointPath = args[i] + checkpointPrefixLen;
+		}
+		else if(strcmp(args[i], RESUME_OPTION) == 0)
+		{
+			options.resume = TRUE;
+		}
+		else if(strncmp(args[i], SHARD_OPTION_PREFIX, shardPrefixLen) == 0)
+		{
+			parseShardOption(args[i] + shardPrefixLen, &options);
+		}
+		else if(strncmp(args[i], OUTPUT_OPTION_PREFIX, outputPrefixLen) == 0)
+		{
+			options.outputFormat = parseOutputFormat(args[i] + outputPrefixLen);
+		}
+		else
+		{
+			fprintf(stderr, UNKNOWN_OPTION_ERROR, args[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	checkValidBand(options.band == NO_BAND || options.mode == GLOBAL_ALIGNMENT);
+	checkValidMultipleAlignment(options);
+	checkValidCheckpoint(options);
+	checkValidOutputFormat(options);
+	if(options.numOfShards != NO_SHARDS && (options.editDistance || options.multipleAlignment))
+	{
+		fprintf(stderr, INVALID_SHARD_ERROR);
 		exit(EXIT_FAILURE);
 	}
+	if(options.numOfThreads < 1)
+	{
+		options.numOfThreads = 1;
+	}
+
+	return options;
 }
 
 /**
@@ -191,427 +738,1750 @@ void checkNoFile(const FILE *fp, const char fileName[])
 }
 
 /**
- * This function checks if a given pointer is a NULL pointer.
- * @param p - the input pointer.
+ * This function checks if a given pointer is a NULL pointer.
+ * @param p - the input pointer.
+ */
+void nullPointerCheckerForAllocatedMemory(const void *p)
+{
+	if(p == NULL)
+	{
+		fprintf(stderr, ERROR_NOT_ENOUGH_MEMORY);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function exits with an error message if a function of the alignment library failed.
+ * @param status - the status the function returned.
+ * @param filePath - the path of the file the function worked on (for the error message).
+ */
+void checkAlignStatus(const AlignStatus status, const char filePath[])
+{
+	if(status == ALIGN_SUCCESS)
+	{
+		return;
+	}
+
+	if(status == ALIGN_ERROR_NO_MEMORY)
+	{
+		fprintf(stderr, ERROR_NOT_ENOUGH_MEMORY);
+	}
+	else if(status == ALIGN_ERROR_FILE_NOT_FOUND)
+	{
+		fprintf(stderr, FILE_DOES_NOT_EXIST_ERROR, filePath);
+	}
+	else if(status == ALIGN_ERROR_INVALID_MATRIX_FILE)
+	{
+		fprintf(stderr, INVALID_MATRIX_FILE_ERROR, filePath);
+	}
+	else
+	{
+		fprintf(stderr, ALIGNMENT_ERROR, alignStatusMessage(status));
+	}
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * This function grows the capacity of an arena (geometrically, so appending to it is amortized
+ * O(1)) until it has room for at least minCapacity bytes.
+ * @param arena - the arena to grow.
+ * @param minCapacity - the minimal capacity the arena needs.
+ */
+void growArena(Arena *arena, const size_t minCapacity)
+{
+	size_t newCapacity = (arena->capacity > 0) ? arena->capacity : INITIAL_ARENA_CAPACITY;
+
+	while(newCapacity < minCapacity)
+	{
+		newCapacity *= GROWTH_FACTOR;
+	}
+
+	arena->bytes = (char*) realloc(arena->bytes, newCapacity);
+	nullPointerCheckerForAllocatedMemory(arena->bytes);
+	arena->capacity = newCapacity;
+}
+
+/**
+ * This function exits with an error message if writing to the checkpoint file failed.
+ * @param isValid - TRUE if the write succeeded, FALSE otherwise.
+ */
+void checkCheckpointWrite(const int isValid)
+{
+	if(!isValid)
+	{
+		fprintf(stderr, CHECKPOINT_WRITE_ERROR, gCheckpointPath);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function calculates the index of a pair (str1Location < str2Location) in the upper
+ * triangle of all the pairs, row after row.
+ * @param str1Location - the location of string 1.
+ * @param str2Location - the location of string 2.
+ * @return the index of the pair.
+ */
+size_t pairIndex(const int str1Location, const int str2Location)
+{
+	size_t i = (size_t) str1Location;
+	return i * (size_t) gNumOfSequences - i * (i + 1) / 2 + (size_t) (str2Location -
+																	  str1Location - 1);
+}
+
+/**
+ * This function returns weather or not a pair was completed by a previous run, whose checkpoint
+ * file was resumed.
+ * @param str1Location - the location of string 1.
+ * @param str2Location - the location of string 2.
+ * @return TRUE if the pair was completed, FALSE otherwise.
+ */
+int isPairCompleted(const int str1Location, const int str2Location)
+{
+	if(gCompletedPairs == NULL)
+	{
+		return FALSE;
+	}
+
+	size_t index = pairIndex(str1Location, str2Location);
+	return (gCompletedPairs[index / BITS_PER_COMPLETED_WORD] >>
+			(index % BITS_PER_COMPLETED_WORD)) & 1;
+}
+
+/**
+ * This function returns weather or not a pair is aligned by this process (it's in its shard).
+ * @param str1Location - the location of string 1.
+ * @param str2Location - the location of string 2.
+ * @return TRUE if the pair is in the shard, FALSE otherwise.
+ */
+int isPairInShard(const int str1Location, const int str2Location)
+{
+	size_t index = pairIndex(str1Location, str2Location);
+	return index >= gFirstPairOfShard && index < gEndPairOfShard;
+}
+
+/**
+ * This function finds the first pair (in the order of the output) whose estimated cost starts at
+ * or after a given cost, when the costs of all the pairs are laid one after the other. The cost of
+ * a pair is the number of cells of its scores matrix.
+ * @param cost - the cost.
+ * @param costOfSuffixes - costOfSuffixes[i] is the sum of (size + 1) of sequences i and after it.
+ * @return the index of the pair, or the number of pairs if there's no such pair.
+ */
+size_t findPairAtCost(uint64_t cost, const uint64_t *costOfSuffixes)
+{
+	int i;
+	int j;
+
+	for(i = 0 ; i < gNumOfSequences - 1 ; i++)
+	{
+		uint64_t rowSize = (uint64_t) gSequencesArray[i].sizeOfValue + 1;
+		uint64_t costOfRow = rowSize * costOfSuffixes[i + 1];
+		if(cost > costOfRow)
+		{
+			cost -= costOfRow;
+			continue;
+		}
+
+		for(j = i + 1 ; j < gNumOfSequences ; j++)
+		{
+			if(cost == 0)
+			{
+				return pairIndex(i, j);
+			}
+			uint64_t costOfPair = rowSize * ((uint64_t) gSequencesArray[j].sizeOfValue + 1);
+			cost = (cost > costOfPair) ? cost - costOfPair : 0;
+		}
+	}
+
+	return (size_t) gNumOfSequences * (size_t) (gNumOfSequences - 1) / 2;
+}
+
+/**
+ * This function sets the range of pairs of a shard. The pairs, in the order of the output, are
+ * split into numOfShards ranges of about the same estimated cost (the number of cells of the
+ * scores matrices), so the shards take about the same time, and depend only on the sizes of the
+ * sequences (every process finds the same shards, and a merge of their outputs in the order of
+ * the shards is the output of a single process).
+ * @param shard - the shard (1 to numOfShards).
+ * @param numOfShards - the number of shards.
+ */
+void setPairsOfShard(const int shard, const int numOfShards)
+{
+	uint64_t *costOfSuffixes = (uint64_t*) malloc(((size_t) gNumOfSequences + 1) *
+												  sizeof(uint64_t));
+	nullPointerCheckerForAllocatedMemory(costOfSuffixes);
+	uint64_t totalCost = 0;
+	int i;
+
+	costOfSuffixes[gNumOfSequences] = 0;
+	for(i = gNumOfSequences - 1 ; i >= 0 ; i--)
+	{
+		uint64_t size = (uint64_t) gSequencesArray[i].sizeOfValue + 1;
+		costOfSuffixes[i] = costOfSuffixes[i + 1] + size;
+		totalCost += size * costOfSuffixes[i + 1];
+	}
+
+	//the bounds are total * shard / numOfShards, without an overflow.
+	uint64_t n = (uint64_t) numOfShards;
+	uint64_t firstCost = totalCost / n * (uint64_t) (shard - 1) +
+						 totalCost % n * (uint64_t) (shard - 1) / n;
+	uint64_t endCost = totalCost / n * (uint64_t) shard + totalCost % n * (uint64_t) shard / n;
+
+	gFirstPairOfShard = findPairAtCost(firstCost, costOfSuffixes);
+	gEndPairOfShard = findPairAtCost(endCost, costOfSuffixes);
+
+	free(costOfSuffixes);
+}
+
+/**
+ * This function calculates the fingerprint of a run (FNV-1a of the residues of all the sequences,
+ * the scores, the mode, the band, the shard, the prefilter and the output options), so a
+ * checkpoint file is never resumed by another run, or by one whose output differs.
+ * @param match - the score for match argument.
+ * @param mismatch - the score for mismatch argument.
+ * @param gap - the score for gap argument.
+ * @param options - the values of the optional arguments.
+ * @return the fingerprint.
+ */
+uint64_t calculateCheckpointFingerprint(const int match, const int mismatch, const int gap,
+										const Options *options)
+{
+	const int values[] = {match, mismatch, gap, (int) options->mode, options->band, options->shard,
+						  options->numOfShards, options->prefilterK, options->prefilterThreshold,
+						  options->printCigar, (int) options->outputFormat};
+	uint64_t fingerprint = FINGERPRINT_OFFSET_BASIS;
+	size_t k;
+
+	for(k = 0 ; k < gResiduesArena.size ; k++)
+	{
+		fingerprint = (fingerprint ^ (unsigned char) gResiduesArena.bytes[k]) * ROLLING_HASH_RADIX;
+	}
+	for(k = 0 ; k < sizeof(values) / sizeof(values[0]) ; k++)
+	{
+		fingerprint = (fingerprint ^ (uint32_t) values[k]) * ROLLING_HASH_RADIX;
+	}
+	for(k = 0 ; options->matrixPath != NULL && options->matrixPath[k] != EMPTY_CHAR ; k++)
+	{
+		fingerprint = (fingerprint ^ (unsigned char) options->matrixPath[k]) * ROLLING_HASH_RADIX;
+	}
+
+	return fingerprint;
+}
+
+/**
+ * This function reads the checkpoint file of a previous run, and marks all the pairs in it as
+ * completed. A record which was cut by a crash in the middle of its write is truncated from the
+ * file, so new records are appended right after the last whole one.
+ * @param fp - the checkpoint file.
+ * @param header - the header the file must have.
+ */
+void readCheckpointFile(FILE *fp, const CheckpointHeader *header)
+{
+	CheckpointHeader fileHeader;
+	CheckpointRecord record;
+	size_t numOfPairs = (size_t) gNumOfSequences * (size_t) (gNumOfSequences - 1) / 2;
+
+	if(fread(&fileHeader, sizeof(fileHeader), 1, fp) != 1 ||
+	   memcmp(fileHeader.magic, header->magic, CHECKPOINT_MAGIC_SIZE) != 0 ||
+	   fileHeader.numOfSequences != header->numOfSequences ||
+	   fileHeader.fingerprint != header->fingerprint)
+	{
+		fprintf(stderr, INVALID_CHECKPOINT_FILE_ERROR, gCheckpointPath);
+		exit(EXIT_FAILURE);
+	}
+
+	gCompletedPairs = (uint64_t*) calloc(numOfPairs / BITS_PER_COMPLETED_WORD + 1,
+										 sizeof(uint64_t));
+	nullPointerCheckerForAllocatedMemory(gCompletedPairs);
+
+	while(fread(&record, sizeof(record), 1, fp) == 1)
+	{
+		if(record.str1Location >= record.str2Location ||
+		   record.str2Location >= (uint32_t) gNumOfSequences)
+		{
+			fprintf(stderr, INVALID_CHECKPOINT_FILE_ERROR, gCheckpointPath);
+			exit(EXIT_FAILURE);
+		}
+
+		size_t index = pairIndex((int) record.str1Location, (int) record.str2Location);
+		if(!isPairCompleted((int) record.str1Location, (int) record.str2Location))
+		{
+			gCompletedPairs[index / BITS_PER_COMPLETED_WORD] |=
+					(uint64_t) 1 << (index % BITS_PER_COMPLETED_WORD);
+			gNumOfResumedPairs++;
+		}
+	}
+
+	long validSize = ftell(fp);
+	validSize -= (validSize - (long) sizeof(fileHeader)) % (long) sizeof(record);
+	checkCheckpointWrite(truncate(gCheckpointPath, (off_t) validSize) == 0);
+}
+
+/**
+ * This function opens the checkpoint file: a new one with a header, or, when resuming, the
+ * existing one (if there's one), whose completed pairs are skipped by this run.
+ * @param options - the values of the optional arguments.
+ * @param fingerprint - the fingerprint of the run.
+ */
+void openCheckpointFile(const Options *options, const uint64_t fingerprint)
+{
+	CheckpointHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_SIZE);
+	header.numOfSequences = (uint32_t) gNumOfSequences;
+	header.fingerprint = fingerprint;
+	gCheckpointPath = options->checkpointPath;
+	gLastCheckpointTime = time(NULL);
+
+	FILE *fp = options->resume ? fopen(gCheckpointPath, READ_BINARY_MODE) : NULL;
+	if(fp != NULL)
+	{
+		readCheckpointFile(fp, &header);
+		fclose(fp);
+		gCheckpointFile = fopen(gCheckpointPath, APPEND_BINARY_MODE);
+		checkCheckpointWrite(gCheckpointFile != NULL);
+		fprintf(stderr, PRINT_RESUMED_LINE, gNumOfResumedPairs, gCheckpointPath);
+		return;
+	}
+
+	gCheckpointFile = fopen(gCheckpointPath, WRITE_BINARY_MODE);
+	checkCheckpointWrite(gCheckpointFile != NULL);
+	checkCheckpointWrite(fwrite(&header, sizeof(header), 1, gCheckpointFile) == 1 &&
+						 fflush(gCheckpointFile) == 0);
+}
+
+/**
+ * This function appends the pending records to the checkpoint file. It's called only after the
+ * results of their pairs were flushed to stdout, so a pair in the file is never lost (after a
+ * crash, the results of a few pairs may be written twice, but never not at all).
+ */
+void appendCheckpointRecords()
+{
+	checkCheckpointWrite(fwrite(gPendingCheckpointRecords.bytes, sizeof(char),
+								gPendingCheckpointRecords.size, gCheckpointFile) ==
+						 gPendingCheckpointRecords.size && fflush(gCheckpointFile) == 0);
+	gPendingCheckpointRecords.size = 0;
+	gLastCheckpointTime = time(NULL);
+}
+
+/**
+ * This function makes sure the output buffer has room for count more bytes.
+ * @param count - the number of bytes to make room for.
+ */
+void reserveOutput(const size_t count)
+{
+	if(gOutputBuffer.size + count > gOutputBuffer.capacity)
+	{
+		growArena(&gOutputBuffer, gOutputBuffer.size + count);
+	}
+}
+
+/**
+ * This function writes all the bytes in the output buffer to stdout, in one large write.
+ */
+void flushOutput()
+{
+	if(gOutputBuffer.size > 0)
+	{
+		fwrite(gOutputBuffer.bytes, sizeof(char), gOutputBuffer.size, stdout);
+		gOutputBuffer.size = 0;
+	}
+
+	if(gPendingCheckpointRecords.size > 0)
+	{
+		fflush(stdout);
+		appendCheckpointRecords();
+	}
+}
+
+/**
+ * This function adds the record of a pair whose result was appended to the output buffer to the
+ * pending records of the checkpoint file (if there's one). The output is flushed when there are
+ * many pending records or every few seconds, so the checkpoint file keeps up with runs whose
+ * output is small, or whose alignments are slow.
+ * @param str1Location - the location of string 1.
+ * @param str2Location - the location of string 2.
+ * @param score - the score of the pair.
+ */
+void addCheckpointRecord(const int str1Location, const int str2Location, const int score)
+{
+	if(gCheckpointFile == NULL)
+	{
+		return;
+	}
+
+	CheckpointRecord record = {(uint32_t) str1Location, (uint32_t) str2Location, (int32_t) score};
+	if(gPendingCheckpointRecords.size + sizeof(record) > gPendingCheckpointRecords.capacity)
+	{
+		growArena(&gPendingCheckpointRecords, gPendingCheckpointRecords.size + sizeof(record));
+	}
+	memcpy(gPendingCheckpointRecords.bytes + gPendingCheckpointRecords.size, &record,
+		   sizeof(record));
+	gPendingCheckpointRecords.size += sizeof(record);
+
+	if(gPendingCheckpointRecords.size >= CHECKPOINT_FLUSH_SIZE ||
+	   time(NULL) - gLastCheckpointTime >= CHECKPOINT_INTERVAL_SECONDS)
+	{
+		flushOutput();
+	}
+}
+
+/**
+ * This function appends a formatted string (like printf) to the output buffer.
+ * @param format - the format string.
+ * @param ... - the values to format.
+ */
+void appendFormatToOutput(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	reserveOutput((size_t) len + 1);
+
+	va_start(args, format);
+	vsnprintf(gOutputBuffer.bytes + gOutputBuffer.size, (size_t) len + 1, format, args);
+	va_end(args);
+
+	gOutputBuffer.size += (size_t) len;
+}
+
+/**
+ * This function appends bytes to the output buffer.
+ * @param bytes - the bytes.
+ * @param count - the number of bytes.
+ */
+void appendBytesToOutput(const void *bytes, const size_t count)
+{
+	reserveOutput(count);
+	memcpy(gOutputBuffer.bytes + gOutputBuffer.size, bytes, count);
+	gOutputBuffer.size += count;
+}
+
+/**
+ * This function appends one row of an alignment to the output buffer: the residues of the string,
+ * and a gap char in the columns where the other string has a residue against a gap.
+ * @param alignment - the alignment.
+ * @param value - the string, from the location where the alignment starts in it.
+ * @param gapType - the type of the columns with a gap in this string.
+ */
+void appendAlignmentRowToOutput(const Alignment *alignment, const char *value, const char gapType)
+{
+	reserveOutput((size_t) alignment->numOfColumns);
+
+	char *out = gOutputBuffer.bytes + gOutputBuffer.size;
+	int index;
+
+	for(index = 0 ; index < alignment->numOfColumns ; index++)
+	{
+		if(alignment->columns[index] == gapType)
+		{
+			out[index] = SEPARATOR_CHAR_FOR_GAP;
+		}
+		else
+		{
+			out[index] = *value;
+			value++;
+		}
+	}
+
+	gOutputBuffer.size += (size_t) alignment->numOfColumns;
+}
+
+/**
+ * This function prints the results (i.e. one of the best alignments example and the score) of two
+ * strings according to their locations in the score matrix given by input integers str1Location
+ * and str2Location. The results are appended to the output buffer, which is flushed to stdout
+ * whenever it gets large.
+ * @param sequencesArray - the array of all sequences in the file.
+ * @param str1Location - location in the score matrix for string 1.
+ * @param str2Location - location in the score matrix for string 2.
+ * @param alignment - the best alignment of the two strings.
+ * @param printCigar - TRUE to print the alignment as a CIGAR string, FALSE to print both rows.
+ */
+void printResultOfPair(Sequence *sequencesArray, int str1Location, int str2Location,
+					   const Alignment *alignment, const int printCigar)
+{
+	if(printCigar)
+	{
+		appendFormatToOutput(PRINT_CIGAR_RESULT_LINE, sequencesArray[str1Location].name,
+							 sequencesArray[str2Location].name, alignment->score);
+		appendFormatToOutput("%s", alignment->cigar);
+	}
+	else
+	{
+		appendFormatToOutput(PRINT_RESULT_LINE, sequencesArray[str1Location].name,
+							 sequencesArray[str2Location].name, alignment->score);
+		appendAlignmentRowToOutput(alignment,
+								   sequencesArray[str1Location].value + alignment->startInStr1,
+								   TYPE_OF_GAP_IN_STR1);
+		appendFormatToOutput("%s", TWO_NEW_LINES);
+		appendAlignmentRowToOutput(alignment,
+								   sequencesArray[str2Location].value + alignment->startInStr2,
+								   TYPE_OF_GAP_IN_STR2);
+	}
+
+	if(gOutputBuffer.size >= OUTPUT_FLUSH_SIZE)
+	{
+		flushOutput();
+	}
+}
+
+/**
+ * This function appends a byte to the end of an arena.
+ * @param arena - the arena.
+ * @param byte - the byte to append.
+ */
+void appendByteToArena(Arena *arena, const char byte)
+{
+	if(arena->size == arena->capacity)
+	{
+		growArena(arena, arena->size + 1);
+	}
+
+	arena->bytes[arena->size] = byte;
+	arena->size++;
+}
+
+/**
+ * This function starts a new sequence in the sequences array, whose name and residues will be
+ * appended to the ends of the names arena and the residues arena.
+ */
+void startSequence()
+{
+	if(gNumOfSequences == gSequencesCapacity)
+	{
+		gSequencesCapacity = (gSequencesCapacity > 0) ? gSequencesCapacity * GROWTH_FACTOR :
+							 INITIAL_NUM_OF_SEQUENCES;
+		gSequencesArray = (Sequence*) realloc(gSequencesArray,
+											  (size_t) gSequencesCapacity * sizeof(Sequence));
+		nullPointerCheckerForAllocatedMemory(gSequencesArray);
+	}
+
+	gSequencesArray[gNumOfSequences].sizeOfValue = 0;
+	gSequencesArray[gNumOfSequences].nameOffset = gNamesArena.size;
+	gSequencesArray[gNumOfSequences].valueOffset = gResiduesArena.size;
+	gSequencesArray[gNumOfSequences].name = NULL;
+	gSequencesArray[gNumOfSequences].value = NULL;
+	gNumOfSequences++;
+}
+
+/**
+ * This function ends the last sequence in the sequences array, by terminating its residues in the
+ * residues arena and saving its size.
+ */
+void endSequence()
+{
+	Sequence *sequence = &gSequencesArray[gNumOfSequences - 1];
+
+	sequence->sizeOfValue = (unsigned int) (gResiduesArena.size - sequence->valueOffset);
+	appendByteToArena(&gResiduesArena, EMPTY_CHAR);
+}
+
+/**
+ * This function ends the last sequence the parser of the input file read, like endSequence, but a
+ * sequence without residues (a header line which no sequence lines follow) is dropped, and its
+ * name is removed from the names arena.
+ */
+void endParsedSequence()
+{
+	Sequence *sequence = &gSequencesArray[gNumOfSequences - 1];
+
+	if(gResiduesArena.size == sequence->valueOffset)
+	{
+		gNamesArena.size = sequence->nameOffset;
+		gNumOfSequences--;
+		return;
+	}
+
+	endSequence();
+}
+
+/**
+ * This function sets the name and value pointers of all the sequences, once the arenas don't grow
+ * (and move) anymore.
+ */
+void setSequencesPointers()
+{
+	int seq;
+
+	for(seq = 0 ; seq < gNumOfSequences ; seq++)
+	{
+		gSequencesArray[seq].name = gNamesArena.bytes + gSequencesArray[seq].nameOffset;
+		gSequencesArray[seq].value = gResiduesArena.bytes + gSequencesArray[seq].valueOffset;
+	}
+}
+
+/**
+ * This function parses the input file to an array of sequences. The file is read in large blocks,
+ * the residues of all the sequences are appended to one residues arena and their names to one
+ * names arena, so there is no limit on the number of sequences or on the length of lines, and no
+ * allocation per sequence or per line. A name is the letters and digits right after the '>' of a
+ * header line, and the residues are all the letters of the lines until the next header line. A
+ * header line without residues after it is skipped.
+ * @param fp - the file pointer.
+ */
+void parseFile(FILE *fp)
+{
+	static char buffer[READ_BUFFER_SIZE];
+	ParserState state = AT_LINE_START;
+	int thereIsSequence = FALSE;
+	size_t numOfBytes;
+
+	while((numOfBytes = fread(buffer, sizeof(char), READ_BUFFER_SIZE, fp)) > 0)
+	{
+		size_t k;
+		for(k = 0 ; k < numOfBytes ; k++)
+		{
+			char c = buffer[k];
+
+			if(state == AT_LINE_START && c == FIRST_CHAR_OF_HEADER_LINE)
+			{
+				if(thereIsSequence)
+				{
+					endParsedSequence();
+				}
+				startSequence();
+				thereIsSequence = TRUE;
+				state = IN_HEADER_NAME;
+			}
+			else if(state == IN_HEADER_NAME && (isalnum((unsigned char) c) ||
+												c == FIRST_CHAR_OF_HEADER_LINE))
+			{
+				if(c != FIRST_CHAR_OF_HEADER_LINE)
+				{
+					appendByteToArena(&gNamesArena, c);
+				}
+			}
+			else if(state == IN_HEADER_NAME)
+			{
+				appendByteToArena(&gNamesArena, EMPTY_CHAR);
+				state = (c == NEW_LINE_CHAR) ? AT_LINE_START : IN_HEADER_REST;
+			}
+			else if(c == NEW_LINE_CHAR)
+			{
+				state = AT_LINE_START;
+			}
+			else if(state != IN_HEADER_REST)
+			{
+				state = IN_SEQUENCE_LINE;
+				if(thereIsSequence && isalpha((unsigned char) c))
+				{
+					appendByteToArena(&gResiduesArena, c);
+				}
+			}
+		}
+	}
+
+	if(state == IN_HEADER_NAME)
+	{
+		appendByteToArena(&gNamesArena, EMPTY_CHAR);
+	}
+
+	if(thereIsSequence)
+	{
+		endParsedSequence();
+	}
+
+	setSequencesPointers();
+
+	//we don't forget to close the file after finishing using it!
+	fclose(fp);
+}
+
+/**
+ * This function exits with an error message if the input file can't be indexed, because the lines
+ * of one of its sequences have different lengths.
+ * @param isValid - TRUE if the file can be indexed so far, FALSE otherwise.
+ * @param filePath - the path of the file.
+ */
+void checkValidLinesForIndex(const int isValid, const char filePath[])
+{
+	if(!isValid)
+	{
+		fprintf(stderr, INVALID_LINES_FOR_INDEX_ERROR, filePath);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function adds the index record of one sequence to the end of the index records array.
+ * @param record - the record to add.
+ */
+void addIndexRecord(const IndexRecord record)
+{
+	if(gNumOfIndexRecords == gIndexRecordsCapacity)
+	{
+		gIndexRecordsCapacity = (gIndexRecordsCapacity > 0) ?
+								gIndexRecordsCapacity * GROWTH_FACTOR : INITIAL_NUM_OF_SEQUENCES;
+		gIndexRecords = (IndexRecord*) realloc(gIndexRecords, (size_t) gIndexRecordsCapacity *
+															  sizeof(IndexRecord));
+		nullPointerCheckerForAllocatedMemory(gIndexRecords);
+	}
+
+	gIndexRecords[gNumOfIndexRecords] = record;
+	gNumOfIndexRecords++;
+}
+
+/**
+ * This function ends the line the index builder reads inside a sequence: the first line sets the
+ * number of bases and bytes per line of the sequence, and every other line must have the same
+ * number of bases, except for the last line which may be shorter.
+ * @param record - the index record of the sequence.
+ * @param lineBases - the number of bases in the line.
+ * @param lineBytes - the number of bytes in the line, including its end of line chars.
+ * @param hadShortLine - TRUE if a previous line of the sequence was shorter than its first line.
+ * @param filePath - the path of the file.
+ * @return TRUE if this line is shorter than the first line of the sequence, FALSE otherwise.
+ */
+int endLineOfIndexRecord(IndexRecord *record, const size_t lineBases, const size_t lineBytes,
+						 const int hadShortLine, const char filePath[])
+{
+	if(lineBases == 0)
+	{
+		return TRUE;
+	}
+
+	checkValidLinesForIndex(!hadShortLine, filePath);
+
+	if(record->length == 0)
+	{
+		record->lineBases = lineBases;
+		record->lineWidth = lineBytes;
+	}
+
+	checkValidLinesForIndex(lineBases <= record->lineBases, filePath);
+	record->length += lineBases;
+
+	return lineBases < record->lineBases;
+}
+
+/**
+ * This function builds the index of the input file, and writes it to the index file, in the .fai
+ * format: a line for every sequence with its name, its number of bases, the byte offset of its
+ * first base, the number of bases in each of its lines and the number of bytes in each of its
+ * lines (including the end of line chars), separated by tabs. Before them, a header line has the
+ * size and the modification time (in nanoseconds) of the input file, to tell if the index is stale.
+ * @param filePath - the path of the file.
+ * @param indexPath - the path of the index file.
+ * @param fileStat - the status of the file.
+ */
+void buildIndexFile(const char filePath[], const char indexPath[], const struct stat *fileStat)
+{
+	static char buffer[READ_BUFFER_SIZE];
+	FILE *fp = fopen(filePath, READ_MODE);
+	checkNoFile(fp, filePath);
+
+	ParserState state = AT_LINE_START;
+	int thereIsSequence = FALSE;
+	int hadShortLine = FALSE;
+	IndexRecord record = {0, 0, 0, 0, 0};
+	size_t lineBases = 0;
+	size_t lineBytes = 0;
+	size_t fileOffset = 0;
+	size_t numOfBytes;
+
+	gNumOfIndexRecords = 0;
+	gIndexNamesArena.size = 0;
+
+	while((numOfBytes = fread(buffer, sizeof(char), READ_BUFFER_SIZE, fp)) > 0)
+	{
+		size_t k;
+		for(k = 0 ; k < numOfBytes ; k++, fileOffset++)
+		{
+			char c = buffer[k];
+
+			if(state == AT_LINE_START && c == FIRST_CHAR_OF_HEADER_LINE)
+			{
+				if(thereIsSequence)
+				{
+					addIndexRecord(record);
+				}
+				record = (IndexRecord) {gIndexNamesArena.size, 0, 0, 0, 0};
+				thereIsSequence = TRUE;
+				hadShortLine = FALSE;
+				state = IN_HEADER_NAME;
+			}
+			else if(state == IN_HEADER_NAME && (isalnum((unsigned char) c) ||
+												c == FIRST_CHAR_OF_HEADER_LINE))
+			{
+				if(c != FIRST_CHAR_OF_HEADER_LINE)
+				{
+					appendByteToArena(&gIndexNamesArena, c);
+				}
+			}
+			else if(state == IN_HEADER_NAME || (state == IN_HEADER_REST && c == NEW_LINE_CHAR))
+			{
+				if(state == IN_HEADER_NAME)
+				{
+					appendByteToArena(&gIndexNamesArena, EMPTY_CHAR);
+				}
+				state = (c == NEW_LINE_CHAR) ? AT_LINE_START : IN_HEADER_REST;
+				record.offset = fileOffset + 1;
+			}
+			else if(state != IN_HEADER_REST)
+			{
+				lineBytes++;
+				if(c == NEW_LINE_CHAR)
+				{
+					if(thereIsSequence)
+					{
+						hadShortLine = endLineOfIndexRecord(&record, lineBases, lineBytes,
+															hadShortLine, filePath) || hadShortLine;
+					}
+					lineBases = 0;
+					lineBytes = 0;
+					state = AT_LINE_START;
+				}
+				else
+				{
+					lineBases += (c != CARRIAGE_RETURN_CHAR);
+					state = IN_SEQUENCE_LINE;
+				}
+			}
+		}
+	}
+
+	if(state == IN_HEADER_NAME)
+	{
+		appendByteToArena(&gIndexNamesArena, EMPTY_CHAR);
+	}
+
+	if(thereIsSequence)
+	{
+		endLineOfIndexRecord(&record, lineBases, lineBytes, hadShortLine, filePath);
+		addIndexRecord(record);
+	}
+
+	fclose(fp);
+
+	FILE *indexFp = fopen(indexPath, WRITE_MODE);
+	checkNoFile(indexFp, indexPath);
+
+	fprintf(indexFp, INDEX_HEADER_FORMAT, (unsigned long long) fileStat->st_size,
+			(long long) fileStat->st_mtim.tv_sec, (long) fileStat->st_mtim.tv_nsec);
+	int i;
+	for(i = 0 ; i < gNumOfIndexRecords ; i++)
+	{
+		fprintf(indexFp, INDEX_LINE_FORMAT, gIndexNamesArena.bytes + gIndexRecords[i].nameOffset,
+				(unsigned long long) gIndexRecords[i].length,
+				(unsigned long long) gIndexRecords[i].offset,
+				(unsigned long long) gIndexRecords[i].lineBases,
+				(unsigned long long) gIndexRecords[i].lineWidth);
+	}
+
+	fclose(indexFp);
+}
+
+/**
+ * This function checks if the index file is of the current version of the input file: if its
+ * header line has the size and the modification time of the input file. The time has nanoseconds,
+ * so a file rewritten in the same second the index was built in isn't read by stale offsets.
+ * @param indexPath - the path of the index file.
+ * @param fileStat - the status of the input file.
+ * @return TRUE if the index file is current, FALSE if it's stale or doesn't exist.
+ */
+int isIndexFileCurrent(const char indexPath[], const struct stat *fileStat)
+{
+	FILE *indexFp = fopen(indexPath, READ_MODE);
+	if(indexFp == NULL)
+	{
+		return FALSE;
+	}
+
+	unsigned long long size = 0;
+	long long seconds = 0;
+	long nanoseconds = 0;
+	int isCurrent = fscanf(indexFp, INDEX_HEADER_FORMAT, &size, &seconds, &nanoseconds) ==
+					NUM_OF_INDEX_HEADER_FIELDS && size == (unsigned long long) fileStat->st_size &&
+					seconds == (long long) fileStat->st_mtim.tv_sec &&
+					nanoseconds == (long) fileStat->st_mtim.tv_nsec;
+
+	fclose(indexFp);
+	return isCurrent;
+}
+
+/**
+ * This function reads the index file into the index records array (skipping its header line).
+ * @param indexPath - the path of the index file.
+ */
+void readIndexFile(const char indexPath[])
+{
+	FILE *indexFp = fopen(indexPath, READ_MODE);
+	checkNoFile(indexFp, indexPath);
+
+	char *line = NULL;
+	size_t lineCapacity = 0;
+
+	gNumOfIndexRecords = 0;
+	gIndexNamesArena.size = 0;
+
+	while(getline(&line, &lineCapacity, indexFp) != -1)
+	{
+		char *field = strtok(line, INDEX_SEPARATORS);
+		if(field == NULL || *field == INDEX_HEADER_CHAR)
+		{
+			continue;
+		}
+
+		IndexRecord record = {gIndexNamesArena.size, 0, 0, 0, 0};
+		size_t *numbers[] = {&record.length, &record.offset, &record.lineBases,
+							 &record.lineWidth};
+		size_t nameLen = strlen(field);
+		size_t k;
+
+		for(k = 0 ; k <= nameLen ; k++)
+		{
+			appendByteToArena(&gIndexNamesArena, field[k]);
+		}
+
+		for(k = 0 ; k < sizeof(numbers) / sizeof(numbers[0]) ; k++)
+		{
+			field = strtok(NULL, INDEX_SEPARATORS);
+			if(field == NULL)
+			{
+				fprintf(stderr, INVALID_INDEX_FILE_ERROR, indexPath);
+				exit(EXIT_FAILURE);
+			}
+			*numbers[k] = (size_t) strtoull(field, NULL, BASE_OF_COUNTING);
+		}
+
+		addIndexRecord(record);
+	}
+
+	free(line);
+	fclose(indexFp);
+}
+
+/**
+ * This function finds the index record of a sequence by its name.
+ * @param name - the name of the sequence.
+ * @param nameLen - the length of the name.
+ * @return the index of the record, or NOT_FOUND if there's no sequence with this name.
+ */
+int findIndexRecord(const char *name, const size_t nameLen)
+{
+	int i;
+
+	for(i = 0 ; i < gNumOfIndexRecords ; i++)
+	{
+		const char *recordName = gIndexNamesArena.bytes + gIndexRecords[i].nameOffset;
+		if(strlen(recordName) == nameLen && strncmp(recordName, name, nameLen) == 0)
+		{
+			return i;
+		}
+	}
+
+	return NOT_FOUND;
+}
+
+/**
+ * This function fetches one sequence from the memory mapped input file, by its index record,
+ * into the sequences array, keeping only the letters of its lines.
+ * @param mappedFile - the memory mapped input file.
+ * @param fileSize - the size of the input file.
+ * @param record - the index record of the sequence.
+ */
+void fetchSequence(const char *mappedFile, const size_t fileSize, const IndexRecord *record)
+{
+	const char *name = gIndexNamesArena.bytes + record->nameOffset;
+	size_t k;
+
+	startSequence();
+	do
+	{
+		appendByteToArena(&gNamesArena, *name);
+	} while(*(name++) != EMPTY_CHAR);
+
+	if(gResiduesArena.capacity < gResiduesArena.size + record->length + 1)
+	{
+		growArena(&gResiduesArena, gResiduesArena.size + record->length + 1);
+	}
+
+	size_t remainingBases = record->length;
+	size_t lineOffset = record->offset;
+
+	while(remainingBases > 0 && lineOffset < fileSize)
+	{
+		size_t lineBases = (remainingBases < record->lineBases) ? remainingBases :
+						   record->lineBases;
+		for(k = lineOffset ; k < lineOffset + lineBases && k < fileSize ; k++)
+		{
+			if(isalpha((unsigned char) mappedFile[k]))
+			{
+				gResiduesArena.bytes[gResiduesArena.size] = mappedFile[k];
+				gResiduesArena.size++;
+			}
+		}
+		remainingBases -= lineBases;
+		lineOffset += record->lineWidth;
+	}
+
+	endSequence();
+}
+
+/**
+ * This function loads the sequences of the input file through its index file (which is built, or
+ * rebuilt if it isn't of the current version of the input file): the input file is memory mapped,
+ * and only the selected sequences are read from it - the other sequences are never read or copied.
+ * Like parseFile, loading all the sequences skips the ones without residues.
+ * @param fp - the file pointer of the input file.
+ * @param filePath - the path of the input file.
+ * @param selectedNames - comma separated names of the sequences to load, or NULL for all of them.
+ */
+void loadSequencesWithIndex(FILE *fp, const char filePath[], const char *selectedNames)
+{
+	char *indexPath = (char*) malloc(strlen(filePath) + strlen(INDEX_FILE_SUFFIX) + 1);
+	nullPointerCheckerForAllocatedMemory(indexPath);
+	strcpy(indexPath, filePath);
+	strcat(indexPath, INDEX_FILE_SUFFIX);
+
+	struct stat fileStat;
+	if(fstat(fileno(fp), &fileStat) != 0)
+	{
+		fprintf(stderr, FILE_DOES_NOT_EXIST_ERROR, filePath);
+		exit(EXIT_FAILURE);
+	}
+
+	if(!isIndexFileCurrent(indexPath, &fileStat))
+	{
+		buildIndexFile(filePath, indexPath, &fileStat);
+	}
+	else
+	{
+		readIndexFile(indexPath);
+	}
+
+	size_t fileSize = (size_t) fileStat.st_size;
+	char *mappedFile = NULL;
+	if(fileSize > 0)
+	{
+		mappedFile = (char*) mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+		if(mappedFile == MAP_FAILED)
+		{
+			fprintf(stderr, FILE_DOES_NOT_EXIST_ERROR, filePath);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	int i;
+	if(selectedNames == NULL)
+	{
+		for(i = 0 ; i < gNumOfIndexRecords ; i++)
+		{
+			if(gIndexRecords[i].length > 0)
+			{
+				fetchSequence(mappedFile, fileSize, &gIndexRecords[i]);
+			}
+		}
+	}
+	else
+	{
+		const char *name = selectedNames;
+		while(*name != EMPTY_CHAR)
+		{
+			size_t nameLen = strcspn(name, SELECTED_NAMES_SEPARATOR);
+			i = findIndexRecord(name, nameLen);
+			if(i == NOT_FOUND)
+			{
+				fprintf(stderr, SEQUENCE_NOT_FOUND_ERROR, (int) nameLen, name, filePath);
+				exit(EXIT_FAILURE);
+			}
+			fetchSequence(mappedFile, fileSize, &gIndexRecords[i]);
+			name += nameLen + (name[nameLen] != EMPTY_CHAR);
+		}
+	}
+
+	setSequencesPointers();
+
+	if(mappedFile != NULL)
+	{
+		munmap(mappedFile, fileSize);
+	}
+	fclose(fp);
+
+	free(indexPath);
+	free(gIndexRecords);
+	gIndexRecords = NULL;
+	free(gIndexNamesArena.bytes);
+	gIndexNamesArena.bytes = NULL;
+}
+
+/**
+ * This function packs the residues of all the sequences to 2 bits per nucleotide, and frees the
+ * residues arena (which is not needed anymore). The packed residues of sequence i start at word
+ * packedOffsets[i].
+ * @param packedOffsets - output: the offset of the packed residues of every sequence.
+ * @return the packed residues of all the sequences.
+ */
+uint64_t *packDnaSequences(size_t *packedOffsets)
+{
+	size_t numOfWords = 0;
+	int seq;
+
+	for(seq = 0 ; seq < gNumOfSequences ; seq++)
+	{
+		packedOffsets[seq] = numOfWords;
+		numOfWords += packedDnaSize((int) gSequencesArray[seq].sizeOfValue);
+	}
+
+	uint64_t *packedResidues = (uint64_t*) calloc(numOfWords + 1, sizeof(uint64_t));
+	nullPointerCheckerForAllocatedMemory(packedResidues);
+
+	for(seq = 0 ; seq < gNumOfSequences ; seq++)
+	{
+		if(packDnaString(gSequencesArray[seq].value, (int) gSequencesArray[seq].sizeOfValue,
+						 packedResidues + packedOffsets[seq]) != ALIGN_SUCCESS)
+		{
+			fprintf(stderr, NOT_DNA_SEQUENCE_ERROR, gSequencesArray[seq].name);
+			exit(EXIT_FAILURE);
+		}
+		gSequencesArray[seq].value = NULL;
+	}
+
+	free(gResiduesArena.bytes);
+	gResiduesArena.bytes = NULL;
+
+	return packedResidues;
+}
+
+/**
+ * This function prints the edit distances of all the pairs of (DNA) sequences in the file,
+ * packing the sequences to 2 bits per nucleotide and calculating every distance with Myers'
+ * bit-vector algorithm (editdistance.h). The match bit-vectors of every sequence are built once,
+ * for all of its pairs.
+ */
+void printEditDistancesForFile()
+{
+	size_t *packedOffsets = (size_t*) malloc((size_t) gNumOfSequences * sizeof(size_t));
+	nullPointerCheckerForAllocatedMemory(packedOffsets);
+
+	uint64_t *packedResidues = packDnaSequences(packedOffsets);
+
+	unsigned int maxSize = 0;
+	int i;
+	int j;
+
+	for(i = 0 ; i < gNumOfSequences ; i++)
+	{
+		if(gSequencesArray[i].sizeOfValue > maxSize)
+		{
+			maxSize = gSequencesArray[i].sizeOfValue;
+		}
+	}
+
+	EditDistanceQuery* query = editDistanceQueryAlloc((int) maxSize);
+	nullPointerCheckerForAllocatedMemory(query);
+
+	for(i = 0 ; i < gNumOfSequences ; i++)
+	{
+		setEditDistanceQuery(query, packedResidues + packedOffsets[i],
+							 (int) gSequencesArray[i].sizeOfValue);
+
+		for(j = i + 1 ; j < gNumOfSequences ; j++)
+		{
+			int distance = calculateEditDistance(query, packedResidues + packedOffsets[j],
+												 (int) gSequencesArray[j].sizeOfValue);
+
+			printf(PRINT_EDIT_DISTANCE_LINE, gSequencesArray[i].name, gSequencesArray[j].name,
+				   distance);
+		}
+	}
+
+	freeEditDistanceQuery(&query);
+	free(packedResidues);
+	free(packedOffsets);
+}
+
+/**
+ * This function mixes the bits of a 64 bit hash value (the splitmix64 finalizer), so the smallest
+ * hash values are a uniform sample of the k-mers.
+ * @param hash - the hash value.
+ * @return the mixed hash value.
+ */
+uint64_t mixHash(uint64_t hash)
+{
+	hash ^= hash >> 30;
+	hash *= HASH_MIX_MULTIPLIER_1;
+	hash ^= hash >> 27;
+	hash *= HASH_MIX_MULTIPLIER_2;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+/**
+ * This function compares two hash values, for sorting them in ascending order.
+ * @param a - pointer to the first hash value.
+ * @param b - pointer to the second hash value.
+ * @return negative, zero or positive if the first hash is smaller, equal or bigger.
+ */
+int compareHashes(const void *a, const void *b)
+{
+	uint64_t hashA = *(const uint64_t*) a;
+	uint64_t hashB = *(const uint64_t*) b;
+	return (hashA > hashB) - (hashA < hashB);
+}
+
+/**
+ * This function compares two postings of the k-mers index by their hash values, and then by
+ * their sequences.
+ * @param a - pointer to the first posting.
+ * @param b - pointer to the second posting.
+ * @return negative, zero or positive if the first posting is smaller, equal or bigger.
  */
-void nullPointerCheckerForAllocatedMemory(const void *p)
+int comparePostings(const void *a, const void *b)
 {
-	if(p == NULL)
-	{
-		fprintf(stderr, ERROR_NOT_ENOUGH_MEMORY);
-		exit(EXIT_FAILURE);
-	}
+	const KmerPosting *postingA = (const KmerPosting*) a;
+	const KmerPosting *postingB = (const KmerPosting*) b;
+	int result = compareHashes(&postingA->hash, &postingB->hash);
+	return (result != 0) ? result : postingA->sequence - postingB->sequence;
 }
 
 /**
- * This function calculates the score of best alignment for two input strings.
- * @param str1Rows - input string 1.
- * @param str2Cols - input string 2.
- * @param sizeStr1Rows - the size of input string 1.
- * @param sizeStr2Cols - the size of input string 2.
- * @param match - the score for match argument.
- * @param mismatch - the score for mismatch argument.
- * @param gap - the score for gap argument.
- * @return - score of best alignment of two strings.
+ * This function builds the sketch of a sequence: the SKETCH_SIZE smallest (distinct) hash values
+ * of its k-mers, computed with a rolling hash.
+ * @param sequence - the sequence.
+ * @param k - the length of the k-mers.
+ * @param kmerHashes - a workspace for the hash values of all the k-mers of the sequence.
+ * @param sketch - output: the sketch.
+ * @return the number of hash values in the sketch.
  */
-int calculateBestAlignment(const char *str1Rows, const char *str2Cols,
-		                   const int sizeStr1Rows, const int sizeStr2Cols, const int match,
-		                   const int mismatch, const int gap)
+int buildKmerSketch(const Sequence *sequence, const int k, uint64_t *kmerHashes, uint64_t *sketch)
 {
+	uint64_t radixPowerK = 1;
+	uint64_t rollingHash = 0;
+	unsigned int numOfKmers = 0;
+	unsigned int pos;
 	int i;
-	int mResult = 0;
-	int sResult = 0;
-	int gapResult1 = 0;
-	int gapResult2 = 0;
-	int result = 0;
-
-	CellOfScoresMatrix **scoresMatrix = NULL;
-	scoresMatrix = (CellOfScoresMatrix**) malloc((sizeStr1Rows + 1) *
-												 sizeof(CellOfScoresMatrix*));
 
-	nullPointerCheckerForAllocatedMemory(scoresMatrix);
+	if(sequence->sizeOfValue < (unsigned int) k)
+	{
+		return 0;
+	}
 
-	for(i = 0 ; i < sizeStr1Rows + 1 ; i++)
+	for(i = 0 ; i < k ; i++)
 	{
-		scoresMatrix[i] = NULL;
-		scoresMatrix[i] = (CellOfScoresMatrix*) malloc((sizeStr2Cols + 1) *
-													   sizeof(CellOfScoresMatrix));
-		nullPointerCheckerForAllocatedMemory(scoresMatrix[i]);
+		radixPowerK *= ROLLING_HASH_RADIX;
 	}
 
-	int j;
-	for(j = 0; j < sizeStr1Rows + 1 ; j++)
+	for(pos = 0 ; pos < sequence->sizeOfValue ; pos++)
 	{
-		scoresMatrix[j][INDEX_OF_FIRST_ROW_OR_COLUMN].value = j * gap;
-		if(j == 0)
+		rollingHash = rollingHash * ROLLING_HASH_RADIX + (unsigned char) sequence->value[pos];
+		if(pos >= (unsigned int) k)
 		{
-			scoresMatrix[j][INDEX_OF_FIRST_ROW_OR_COLUMN].prevCellPointer =
-					&scoresMatrix[j][INDEX_OF_FIRST_ROW_OR_COLUMN];
-
-			scoresMatrix[j][INDEX_OF_FIRST_ROW_OR_COLUMN].typeOfPrevCellPointer =
-					TYPE_OF_FIRST_CELL;
+			rollingHash -= radixPowerK * (unsigned char) sequence->value[pos - k];
 		}
-		else
+		if(pos + 1 >= (unsigned int) k)
 		{
-			scoresMatrix[j][INDEX_OF_FIRST_ROW_OR_COLUMN].prevCellPointer =
-					&scoresMatrix[j - 1][INDEX_OF_FIRST_ROW_OR_COLUMN];
-
-			scoresMatrix[j][INDEX_OF_FIRST_ROW_OR_COLUMN].typeOfPrevCellPointer =
-					TYPE_OF_GAP_IN_STR2;
+			kmerHashes[numOfKmers] = mixHash(rollingHash);
+			numOfKmers++;
 		}
-
 	}
-	for(j = 0 ; j < sizeStr2Cols + 1 ; j++)
+
+	qsort(kmerHashes, numOfKmers, sizeof(uint64_t), compareHashes);
+
+	int sketchSize = 0;
+	for(pos = 0 ; pos < numOfKmers && sketchSize < SKETCH_SIZE ; pos++)
 	{
-		scoresMatrix[INDEX_OF_FIRST_ROW_OR_COLUMN][j].value = j * gap;
-		if(j == 0)
+		if(sketchSize == 0 || kmerHashes[pos] != sketch[sketchSize - 1])
 		{
-			scoresMatrix[INDEX_OF_FIRST_ROW_OR_COLUMN][j].prevCellPointer =
-					&scoresMatrix[INDEX_OF_FIRST_ROW_OR_COLUMN][j];
-
-			scoresMatrix[INDEX_OF_FIRST_ROW_OR_COLUMN][j].typeOfPrevCellPointer =
-					TYPE_OF_FIRST_CELL;
+			sketch[sketchSize] = kmerHashes[pos];
+			sketchSize++;
 		}
-		else
-		{
-			scoresMatrix[INDEX_OF_FIRST_ROW_OR_COLUMN][j].prevCellPointer =
-					&scoresMatrix[INDEX_OF_FIRST_ROW_OR_COLUMN][j - 1];
+	}
 
-			scoresMatrix[INDEX_OF_FIRST_ROW_OR_COLUMN][j].typeOfPrevCellPointer =
-					TYPE_OF_GAP_IN_STR1;
-		}
+	return sketchSize;
+}
+
+/**
+ * This function builds the k-mers sketches of all the sequences, and the index of all the sketches
+ * (their hash values and sequences, sorted by hash), once for all the pairs.
+ * @param k - the length of the k-mers.
+ * @param sketches - output: the sketches and their index.
+ */
+void buildKmerSketches(const int k, KmerSketches *sketches)
+{
+	unsigned int maxSize = 0;
+	int seq;
 
+	for(seq = 0 ; seq < gNumOfSequences ; seq++)
+	{
+		if(gSequencesArray[seq].sizeOfValue > maxSize)
+		{
+			maxSize = gSequencesArray[seq].sizeOfValue;
+		}
 	}
 
-	for(i = 0; i < sizeStr1Rows ; i++)
+	uint64_t *kmerHashes = (uint64_t*) malloc(((size_t) maxSize + 1) * sizeof(uint64_t));
+	sketches->hashes = (uint64_t*) malloc((size_t) gNumOfSequences * SKETCH_SIZE *
+										  sizeof(uint64_t));
+	sketches->sizes = (int*) malloc((size_t) gNumOfSequences * sizeof(int));
+	sketches->postings = (KmerPosting*) malloc((size_t) gNumOfSequences * SKETCH_SIZE *
+											   sizeof(KmerPosting));
+	nullPointerCheckerForAllocatedMemory(kmerHashes);
+	nullPointerCheckerForAllocatedMemory(sketches->hashes);
+	nullPointerCheckerForAllocatedMemory(sketches->sizes);
+	nullPointerCheckerForAllocatedMemory(sketches->postings);
+
+	sketches->numOfPostings = 0;
+
+	for(seq = 0 ; seq < gNumOfSequences ; seq++)
 	{
-		for(j = 0 ; j < sizeStr2Cols ; j++)
+		uint64_t *sketch = sketches->hashes + (size_t) seq * SKETCH_SIZE;
+		int h;
+
+		sketches->sizes[seq] = buildKmerSketch(&gSequencesArray[seq], k, kmerHashes, sketch);
+
+		for(h = 0 ; h < sketches->sizes[seq] ; h++)
 		{
-			gapResult1 = scoresMatrix[i][j + 1].value + gap;
-			gapResult2 = scoresMatrix[i + 1][j].value + gap;
+			sketches->postings[sketches->numOfPostings].hash = sketch[h];
+			sketches->postings[sketches->numOfPostings].sequence = seq;
+			sketches->numOfPostings++;
+		}
+	}
 
-			if(str1Rows[i] == str2Cols[j])
-			{
-				mResult = scoresMatrix[i][j].value + match;
-				result = maxOfThreeCalculator(mResult, gapResult1, gapResult2);
+	qsort(sketches->postings, sketches->numOfPostings, sizeof(KmerPosting), comparePostings);
 
-				if(result == mResult)
-				{
-					scoresMatrix[i + 1][j + 1].typeOfPrevCellPointer = TYPE_OF_MATCH;
-					scoresMatrix[i + 1][j + 1].prevCellPointer = &scoresMatrix[i][j];
-				}
-				else if(result == gapResult1)
-				{
-					scoresMatrix[i + 1][j + 1].prevCellPointer = &scoresMatrix[i][j + 1];
-					scoresMatrix[i + 1][j + 1].typeOfPrevCellPointer = TYPE_OF_GAP_IN_STR2;
-				}
-				else
-				{
-					scoresMatrix[i + 1][j + 1].prevCellPointer = &scoresMatrix[i + 1][j];
-					scoresMatrix[i + 1][j + 1].typeOfPrevCellPointer = TYPE_OF_GAP_IN_STR1;
-				}
+	free(kmerHashes);
+}
 
-			}
-			else
-			{
-				sResult = scoresMatrix[i][j].value + mismatch;
-				result = maxOfThreeCalculator(sResult, gapResult1, gapResult2);
+/**
+ * This function frees all the memory of the k-mers sketches.
+ * @param sketches - the sketches.
+ */
+void freeKmerSketches(KmerSketches *sketches)
+{
+	free(sketches->hashes);
+	sketches->hashes = NULL;
+	free(sketches->sizes);
+	sketches->sizes = NULL;
+	free(sketches->postings);
+	sketches->postings = NULL;
+}
 
-				if(result == sResult)
-				{
-					scoresMatrix[i + 1][j + 1].typeOfPrevCellPointer = TYPE_OF_MISMATCH;
-					scoresMatrix[i + 1][j + 1].prevCellPointer = &scoresMatrix[i][j];
-				}
-				else if(result == gapResult1)
-				{
-					scoresMatrix[i + 1][j + 1].prevCellPointer = &scoresMatrix[i][j + 1];
-					scoresMatrix[i + 1][j + 1].typeOfPrevCellPointer = TYPE_OF_GAP_IN_STR2;
+/**
+ * This function counts, through the index of the sketches, the hash values every sequence after
+ * a given sequence shares with its sketch. Only sequences which share any hash value are visited.
+ * @param sketches - the sketches and their index.
+ * @param seq - the given sequence.
+ * @param sharedCounts - the counters of shared hash values of all the sequences (all 0 before).
+ * @param touchedSequences - output: the sequences whose counter is not 0.
+ * @return the number of touched sequences.
+ */
+int countSharedKmerHashes(const KmerSketches *sketches, const int seq, int *sharedCounts,
+						  int *touchedSequences)
+{
+	const uint64_t *sketch = sketches->hashes + (size_t) seq * SKETCH_SIZE;
+	int numOfTouched = 0;
+	int h;
 
-				}
-				else
-				{
-					scoresMatrix[i + 1][j + 1].prevCellPointer = &scoresMatrix[i + 1][j];
-					scoresMatrix[i + 1][j + 1].typeOfPrevCellPointer = TYPE_OF_GAP_IN_STR1;
-				}
+	for(h = 0 ; h < sketches->sizes[seq] ; h++)
+	{
+		//binary search for the posting of this hash value and this sequence.
+		size_t low = 0;
+		size_t high = sketches->numOfPostings;
+		KmerPosting key = {sketch[h], seq};
 
+		while(low < high)
+		{
+			size_t middle = low + (high - low) / 2;
+			if(comparePostings(&sketches->postings[middle], &key) <= 0)
+			{
+				low = middle + 1;
 			}
+			else
+			{
+				high = middle;
+			}
+		}
 
-			scoresMatrix[i + 1][j + 1].value = result;
-
+		//all the postings after it with the same hash value are of later sequences.
+		for( ; low < sketches->numOfPostings && sketches->postings[low].hash == sketch[h] ; low++)
+		{
+			int other = sketches->postings[low].sequence;
+			if(sharedCounts[other] == 0)
+			{
+				touchedSequences[numOfTouched] = other;
+				numOfTouched++;
+			}
+			sharedCounts[other]++;
 		}
 	}
 
-	int finalResult = 0;
-	finalResult = scoresMatrix[sizeStr1Rows][sizeStr2Cols].value;
-
-	CellOfScoresMatrix tempCell = scoresMatrix[sizeStr1Rows][sizeStr2Cols];
-
-	int strIndex = 0;
-	int maxSizeDoubled = 0;
+	return numOfTouched;
+}
 
-	if(sizeStr1Rows < sizeStr2Cols)
+/**
+ * This function estimates the similarity of two sequences, as the Jaccard index of their k-mers:
+ * the SKETCH_SIZE smallest hash values of the union of the two (sorted) sketches are the smallest
+ * of the union of the k-mers of the sequences, and the percentage of them that are in both
+ * sketches estimates the Jaccard index (the bottom-k estimate).
+ * @param sketches - the sketches.
+ * @param seq1 - the first sequence.
+ * @param seq2 - the second sequence.
+ * @param sharedCount - the number of hash values the two sketches share.
+ * @return the estimated similarity (0 - 100), or FULL_SIMILARITY if a sequence is shorter than k
+ *         (so it can't be estimated).
+ */
+int estimateSimilarity(const KmerSketches *sketches, const int seq1, const int seq2,
+					   const int sharedCount)
+{
+	const uint64_t *sketch1 = sketches->hashes + (size_t) seq1 * SKETCH_SIZE;
+	const uint64_t *sketch2 = sketches->hashes + (size_t) seq2 * SKETCH_SIZE;
+	int size1 = sketches->sizes[seq1];
+	int size2 = sketches->sizes[seq2];
+	int pos1 = 0;
+	int pos2 = 0;
+	int sizeOfUnion = 0;
+	int sharedInUnion = 0;
+
+	if(size1 == 0 || size2 == 0)
 	{
-		maxSizeDoubled = sizeStr2Cols;
+		return FULL_SIMILARITY;
 	}
-	else
+	if(sharedCount == 0)
 	{
-		maxSizeDoubled = sizeStr1Rows;
+		return 0;
 	}
 
-	maxSizeDoubled *= 2;
-
-	gMatchRestorationDecoder = NULL;
-	gMatchRestorationDecoder = (char*) calloc((size_t) maxSizeDoubled + 1, sizeof(char));
-	nullPointerCheckerForAllocatedMemory(gMatchRestorationDecoder);
-
-	while(tempCell.typeOfPrevCellPointer != TYPE_OF_FIRST_CELL)
+	//merge the two sketches, until the union has SKETCH_SIZE hash values.
+	while(sizeOfUnion < SKETCH_SIZE && (pos1 < size1 || pos2 < size2))
 	{
-
-		if(tempCell.typeOfPrevCellPointer == TYPE_OF_MATCH)
-		{
-
-			gMatchRestorationDecoder[strIndex] = TYPE_OF_MATCH;
-			strIndex++;
-			tempCell = *(tempCell.prevCellPointer);
-			continue;
-		}
-		else if(tempCell.typeOfPrevCellPointer == TYPE_OF_MISMATCH)
+		if(pos2 == size2 || (pos1 < size1 && sketch1[pos1] < sketch2[pos2]))
 		{
-			gMatchRestorationDecoder[strIndex] = TYPE_OF_MISMATCH;
-			strIndex++;
-			tempCell = *(tempCell.prevCellPointer);
-			continue;
+			pos1++;
 		}
-		else if(tempCell.typeOfPrevCellPointer == TYPE_OF_GAP_IN_STR2)
+		else if(pos1 == size1 || sketch2[pos2] < sketch1[pos1])
 		{
-			gMatchRestorationDecoder[strIndex] = TYPE_OF_GAP_IN_STR2;
-			strIndex++;
-			tempCell = *(tempCell.prevCellPointer);
-			continue;
+			pos2++;
 		}
-		else if(tempCell.typeOfPrevCellPointer == TYPE_OF_GAP_IN_STR1)
+		else
 		{
-			gMatchRestorationDecoder[strIndex] = TYPE_OF_GAP_IN_STR1;
-			strIndex++;
-			tempCell = *(tempCell.prevCellPointer);
-			continue;
+			sharedInUnion++;
+			pos1++;
+			pos2++;
 		}
-
+		sizeOfUnion++;
 	}
 
-	gMatchRestorationDecoder[strIndex] = EMPTY_CHAR;
+	return sharedInUnion * FULL_SIMILARITY / sizeOfUnion;
+}
+
+/**
+ * This function calculates the score of the alignment of every sequence to itself, which the
+ * distances of the pairs are relative to.
+ * @param aligner - the aligner.
+ * @param options - the values of the optional arguments (mode and band).
+ * @return the scores, which are freed by the caller.
+ */
+int *calculateSelfScores(Aligner* aligner, const Options *options)
+{
+	int *selfScores = (int*) malloc((size_t) gNumOfSequences * sizeof(int));
+	nullPointerCheckerForAllocatedMemory(selfScores);
+	Alignment alignment;
+	int i;
 
-	//Now we free all the allocated memory we used in the heap for the scores Matrix.
-	for(i = 0 ; i < sizeStr1Rows + 1 ; i++)
+	for(i = 0 ; i < gNumOfSequences ; i++)
 	{
-		free(scoresMatrix[i]);
-		scoresMatrix[i] = NULL;
+		checkAlignStatus(alignSequences(aligner, gSequencesArray[i].value,
+										(int) gSequencesArray[i].sizeOfValue,
+										gSequencesArray[i].value,
+										(int) gSequencesArray[i].sizeOfValue, options->mode,
+										options->band, &alignment), NULL);
+		selfScores[i] = alignment.score;
 	}
 
-	free(scoresMatrix);
-	scoresMatrix = NULL;
-
-	return finalResult;
+	return selfScores;
 }
 
 /**
- * This function prints the results (i.e. one of the best alignments example and the score) of two
- * strings according to their locations in the score matrix given by input integers str1Location
- * and str2Location.
- * @param sequencesArray - the array of all sequences in the file.
- * @param str1Location - location in the score matrix for string 1.
- * @param str2Location - location in the score matrix for string 2.
- * @param result - the result score of best alignments of two strings.
+ * This function prints the header of a score matrix output: the binary header and the names
+ * table, or the number of sequences line of PHYLIP.
+ * @param outputFormat - the output format.
  */
-void printResultOfPair(Sequence *sequencesArray, int str1Location, int str2Location, int result)
+void printScoreMatrixHeader(const OutputFormat outputFormat)
 {
-	printf(PRINT_RESULT_LINE, sequencesArray[str1Location].name,
-		   sequencesArray[str2Location].name, result);
+	if(outputFormat == PHYLIP_OUTPUT)
+	{
+		appendFormatToOutput(PHYLIP_NUM_OF_SEQUENCES_LINE, gNumOfSequences);
+		return;
+	}
 
-	int decoderLen = (int) strlen(gMatchRestorationDecoder);
-	int index;
-	int s = 0;
+	ScoreMatrixHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SCORE_MATRIX_MAGIC, SCORE_MATRIX_MAGIC_SIZE);
+	header.numOfSequences = (uint32_t) gNumOfSequences;
+	appendBytesToOutput(&header, sizeof(header));
 
-	for(index = decoderLen - 1 ; index >= 0 ; index--)
+	int i;
+	for(i = 0 ; i < gNumOfSequences ; i++)
 	{
+		uint32_t sizeOfName = (uint32_t) strlen(gSequencesArray[i].name);
+		appendBytesToOutput(&sizeOfName, sizeof(sizeOfName));
+		appendBytesToOutput(gSequencesArray[i].name, sizeOfName);
+	}
+}
 
-		if(gMatchRestorationDecoder[index] == TYPE_OF_MATCH ||
-		   gMatchRestorationDecoder[index] == TYPE_OF_MISMATCH ||
-		   gMatchRestorationDecoder[index] == TYPE_OF_GAP_IN_STR2)
-		{
-			printf("%c", sequencesArray[str1Location].value[s]);
-			s++;
-		}
-		else if(gMatchRestorationDecoder[index] == TYPE_OF_GAP_IN_STR1)
-		{
-			printf("%c", SEPARATOR_CHAR_FOR_GAP);
-		}
+/**
+ * This function prints the start of a row of a score matrix output: the score of the sequence
+ * against itself, or the name of the sequence in PHYLIP.
+ * @param outputFormat - the output format.
+ * @param row - the row.
+ * @param selfScores - the score of every sequence against itself.
+ */
+void printStartOfScoreMatrixRow(const OutputFormat outputFormat, const int row,
+								const int *selfScores)
+{
+	if(outputFormat == PHYLIP_OUTPUT)
+	{
+		appendFormatToOutput(PHYLIP_NAME_FORMAT, gSequencesArray[row].name);
+	}
+	else
+	{
+		int32_t score = (int32_t) selfScores[row];
+		appendBytesToOutput(&score, sizeof(score));
+	}
+}
+
+/**
+ * This function prints the end of a row of a score matrix output (a new line in PHYLIP).
+ * @param outputFormat - the output format.
+ */
+void printEndOfScoreMatrixRow(const OutputFormat outputFormat)
+{
+	if(outputFormat == PHYLIP_OUTPUT)
+	{
+		appendFormatToOutput("%s", NEW_LINE_STRING);
+	}
+}
 
+/**
+ * This function prints the score of a pair to a score matrix output, as soon as the pair is
+ * aligned: the output is the upper triangle of the matrix, row after row, so nothing but the
+ * self scores is kept. PHYLIP gets the distance (score(i, i) + score(j, j)) / 2 - score(i, j),
+ * in its upper triangular format. The first pair of a row starts it, and the last one ends it
+ * (and the last pair of all prints the last row, which has only a start), before the pair is
+ * added to the checkpoint, so a resumed run never prints a part of a row twice.
+ * @param outputFormat - the output format.
+ * @param str1Location - the location of string 1.
+ * @param str2Location - the location of string 2.
+ * @param score - the score of the pair, or SKIPPED_PAIR_SCORE.
+ * @param selfScores - the score of every sequence against itself.
+ */
+void printScoreOfPair(const OutputFormat outputFormat, const int str1Location,
+					  const int str2Location, const int score, const int *selfScores)
+{
+	if(str2Location == str1Location + 1)
+	{
+		printStartOfScoreMatrixRow(outputFormat, str1Location, selfScores);
 	}
 
-	printf("%s", TWO_NEW_LINES);
-	s = 0;
+	if(outputFormat == PHYLIP_OUTPUT)
+	{
+		appendFormatToOutput(PHYLIP_DISTANCE_FORMAT, (selfScores[str1Location] +
+													  selfScores[str2Location]) / 2.0 - score);
+	}
+	else
+	{
+		int32_t packedScore = (int32_t) score;
+		appendBytesToOutput(&packedScore, sizeof(packedScore));
+	}
 
-	for(index = decoderLen - 1 ; index >= 0 ; index--)
+	if(str2Location == gNumOfSequences - 1)
 	{
-		if(gMatchRestorationDecoder[index] == TYPE_OF_MATCH ||
-		   gMatchRestorationDecoder[index] == TYPE_OF_MISMATCH ||
-		   gMatchRestorationDecoder[index] == TYPE_OF_GAP_IN_STR1)
-		{
-			printf("%c", sequencesArray[str2Location].value[s]);
-			s++;
-		}
-		else if(gMatchRestorationDecoder[index] == TYPE_OF_GAP_IN_STR2)
+		printEndOfScoreMatrixRow(outputFormat);
+		if(str1Location == gNumOfSequences - 2)
 		{
-			printf("%c", SEPARATOR_CHAR_FOR_GAP);
+			printStartOfScoreMatrixRow(outputFormat, str2Location, selfScores);
+			printEndOfScoreMatrixRow(outputFormat);
 		}
+	}
 
+	if(gOutputBuffer.size >= OUTPUT_FLUSH_SIZE)
+	{
+		flushOutput();
 	}
+	addCheckpointRecord(str1Location, str2Location, score);
 }
 
 /**
- * This function parses the input file to an array of sequences.
- * @param fp - the file pointer.
+ * This function prints the final results of all the pairs comparisons of strings in the file.
+ * If the k-mers prefilter is on, pairs whose estimated similarity is below its threshold are not
+ * aligned, and are reported separately (to stderr) instead.
+ * @param aligner - the aligner, which has the scores and the workspaces of all the alignments.
+ * @param options - the values of the optional arguments (mode, band and prefilter).
+ * With a score matrix output format, only the scores are printed, as soon as they're calculated.
+ * @param scores - if not NULL, the scores of all the pairs (and of every sequence against itself)
+ *                 are stored in it, as a gNumOfSequences * gNumOfSequences matrix, instead of
+ *                 being printed.
  */
-void parseFile(FILE *fp)
-
+void printFinalResultsForFile(Aligner* aligner, const Options *options, int *scores)
 {
-	char line[MAX_SIZE_OF_LINE] = {EMPTY_CHAR};
-	int thereIsSequence = FALSE;
-	unsigned int rowNumForSequence = 0;
-	Sequence tempSequence;
-	tempSequence = (Sequence) EMPTY_SEQUENCE;
-	unsigned int sizeOfPrevLine = 0;
+	int i;
+	int j;
+	Alignment alignment;
+	//a resumed run appends to the output of the previous runs.
+	int isFirstPair = (gNumOfResumedPairs == 0);
+	KmerSketches sketches = {NULL, NULL, NULL, 0};
+	int *sharedCounts = NULL;
+	int *touchedSequences = NULL;
+	int *selfScores = NULL;
+
+	if(scores != NULL || options->outputFormat != ALIGNMENTS_OUTPUT)
+	{
+		selfScores = calculateSelfScores(aligner, options);
+	}
+	if(options->outputFormat != ALIGNMENTS_OUTPUT)
+	{
+		printScoreMatrixHeader(options->outputFormat);
+	}
+
+	//the output of a shard starts with its header line (a resumed one already has it).
+	if(options->numOfShards != NO_SHARDS && isFirstPair)
+	{
+		appendFormatToOutput(SHARD_HEADER_LINE, options->shard, options->numOfShards);
+	}
 
-	while (fgets(line, MAX_SIZE_OF_LINE, fp) != NULL)
+	if(options->prefilterK != NO_PREFILTER)
 	{
-		unsigned int sizeOfLine = 0;
-		while(line[sizeOfLine] != EMPTY_CHAR && (isalpha(line[sizeOfLine]) ||
-			  (line[sizeOfLine] >= ZERO_CHAR && line[sizeOfLine] <= NINE_CHAR) ||
-			  line[sizeOfLine] == FIRST_CHAR_OF_HEADER_LINE))
+		buildKmerSketches(options->prefilterK, &sketches);
+		sharedCounts = (int*) calloc((size_t) gNumOfSequences, sizeof(int));
+		touchedSequences = (int*) malloc((size_t) gNumOfSequences * sizeof(int));
+		nullPointerCheckerForAllocatedMemory(sharedCounts);
+		nullPointerCheckerForAllocatedMemory(touchedSequences);
+	}
+
+	for(i = 0 ; i < gNumOfSequences ; i++)
+	{
+		int numOfTouched = 0;
+		if(options->prefilterK != NO_PREFILTER)
+		{
+			numOfTouched = countSharedKmerHashes(&sketches, i, sharedCounts, touchedSequences);
+		}
 
+		if(scores != NULL)
 		{
-			sizeOfLine++;
+			scores[(size_t) i * gNumOfSequences + i] = selfScores[i];
 		}
 
-		if(line[0] == FIRST_CHAR_OF_HEADER_LINE)
+		for(j = i + 1 ; j < gNumOfSequences ; j++)
 		{
-			thereIsSequence = TRUE;
-			if(rowNumForSequence > 0)
+			if(!isPairInShard(i, j) || isPairCompleted(i, j))
 			{
-				tempSequence.sizeOfValue = (unsigned int) strlen(tempSequence.value);
-				gSequencesArray[gNumOfSequences] = tempSequence;
-				gNumOfSequences++;
-				rowNumForSequence = 0;
+				continue;
 			}
 
-			unsigned int j;
-			for(j = 1 ; j < sizeOfLine ; j++)
+			if(options->prefilterK != NO_PREFILTER)
 			{
-				if(isalpha(line[j]) || (line[j] >= ZERO_CHAR && line[j] <= NINE_CHAR))
+				int similarity = estimateSimilarity(&sketches, i, j, sharedCounts[j]);
+				if(similarity < options->prefilterThreshold)
 				{
-					tempSequence.name[j - 1] = line[j];
+					fprintf(stderr, PRINT_SKIPPED_PAIR_LINE, gSequencesArray[i].name,
+							gSequencesArray[j].name, similarity);
+					if(options->outputFormat == SCORES_OUTPUT)
+					{
+						printScoreOfPair(options->outputFormat, i, j, SKIPPED_PAIR_SCORE,
+										 selfScores);
+					}
+					continue;
 				}
 			}
-			tempSequence.name[sizeOfLine - 1] = EMPTY_CHAR;
-
-			continue;
 
-		}
+			checkAlignStatus(alignSequences(aligner, gSequencesArray[i].value,
+											(int) gSequencesArray[i].sizeOfValue,
+											gSequencesArray[j].value,
+											(int) gSequencesArray[j].sizeOfValue, options->mode,
+											options->band, &alignment), NULL);
 
-		if(rowNumForSequence == 0)
-		{
-			tempSequence.value = NULL;
-			tempSequence.value = (char*) calloc(sizeOfLine + 1, sizeof(char));
-			nullPointerCheckerForAllocatedMemory(tempSequence.value);
-			unsigned int i;
-			for(i = 0 ; i < sizeOfLine ; i++)
+			if(scores != NULL)
 			{
-				if(isalpha(line[i]))
-				{
-					tempSequence.value[i] = line[i];
-				}
+				scores[(size_t) i * gNumOfSequences + j] = alignment.score;
+				scores[(size_t) j * gNumOfSequences + i] = alignment.score;
+				continue;
 			}
 
-			rowNumForSequence++;
-			sizeOfPrevLine = sizeOfLine;
-		}
-		else
-		{
-			tempSequence.value = (char*) realloc(tempSequence.value, (rowNumForSequence + 1) *
-			                                     MAX_SIZE_OF_LINE + 1);
-
-			nullPointerCheckerForAllocatedMemory(tempSequence.value);
-			rowNumForSequence++;
+			if(options->outputFormat != ALIGNMENTS_OUTPUT)
+			{
+				printScoreOfPair(options->outputFormat, i, j, alignment.score, selfScores);
+				continue;
+			}
 
-			unsigned int i;
-			for(i = 0 ; i < sizeOfLine ; i++)
+			//the results of every two pairs are separated by new lines (but not at the end).
+			if(!isFirstPair)
 			{
-				if(isalpha(line[i]))
-				{
-					tempSequence.value[i + sizeOfPrevLine] = line[i];
-				}
+				appendFormatToOutput("%s", TWO_NEW_LINES);
 			}
-			sizeOfPrevLine += sizeOfLine;
+			isFirstPair = FALSE;
+			printResultOfPair(gSequencesArray, i, j, &alignment, options->printCigar);
+			addCheckpointRecord(i, j, alignment.score);
+
 		}
 
+		while(numOfTouched > 0)
+		{
+			numOfTouched--;
+			sharedCounts[touchedSequences[numOfTouched]] = 0;
+		}
 	}
 
-	if(thereIsSequence)
-	{
-		tempSequence.sizeOfValue = (unsigned int) strlen(tempSequence.value);
-		gSequencesArray[gNumOfSequences] = tempSequence;
-		gNumOfSequences++;
+	flushOutput();
+	free(selfScores);
 
+	if(options->prefilterK != NO_PREFILTER)
+	{
+		freeKmerSketches(&sketches);
+		free(sharedCounts);
+		free(touchedSequences);
 	}
-
-	//we don't forget to close the file after finishing using it!
-	fclose(fp);
 }
 
 /**
- * This function prints the final results of all the pairs comparisons of strings in the file.
- * @param match - the match score parameter.
- * @param mismatch - the mismatch score parameter.
- * @param gap - the gap score parameter.
+ * This function prints the multiple alignment of all the sequences in the file, as aligned FASTA
+ * (in the order of the file). It reuses the scores of all the pairs, and aligns the sequences
+ * progressively along a guide tree built on them.
+ * @param aligner - the aligner, whose scores all the alignments use.
+ * @param options - the values of the optional arguments (mode, band and number of threads).
  */
-void printFinalResultsForFile(const int match, const int mismatch, const int gap)
+void printMultipleAlignmentForFile(Aligner* aligner, const Options *options)
 {
-	int i;
-	int j;
-	int result;
+	size_t numOfSequences = (size_t) gNumOfSequences;
+	int *scores = (int*) malloc(numOfSequences * numOfSequences * sizeof(int));
+	const char **values = (const char**) malloc(numOfSequences * sizeof(char*));
+	int *sizes = (int*) malloc(numOfSequences * sizeof(int));
+	nullPointerCheckerForAllocatedMemory(scores);
+	nullPointerCheckerForAllocatedMemory(values);
+	nullPointerCheckerForAllocatedMemory(sizes);
+
+	printFinalResultsForFile(aligner, options, scores);
 
+	int i;
 	for(i = 0 ; i < gNumOfSequences ; i++)
 	{
-		for(j = i; j < gNumOfSequences ; j++)
-		{
-			if(i == j)
-			{
-				continue;
-			}
-
-			result = calculateBestAlignment(gSequencesArray[i].value,
-					                                          gSequencesArray[j].value,
-					                                          gSequencesArray[i].sizeOfValue,
-					                                          gSequencesArray[j].sizeOfValue,
-					                                          match, mismatch, gap);
-
-			//if you are in the last test to print its results - at the end don't print new lines.
-			if(i == gNumOfSequences - 2 && j == gNumOfSequences - 1)
-			{
-				printResultOfPair(gSequencesArray, i, j, result);
-			}
-			else
-			{
-				printResultOfPair(gSequencesArray, i, j, result);
-				printf("%s", TWO_NEW_LINES);
-			}
+		values[i] = gSequencesArray[i].value;
+		sizes[i] = (int) gSequencesArray[i].sizeOfValue;
+	}
 
-			free(gMatchRestorationDecoder);
-			gMatchRestorationDecoder = NULL;
+	MultipleAlignment multipleAlignment;
+	checkAlignStatus(alignMultiple(aligner, values, sizes, gNumOfSequences, scores,
+								   options->numOfThreads, &multipleAlignment), NULL);
 
+	for(i = 0 ; i < gNumOfSequences ; i++)
+	{
+		appendFormatToOutput(PRINT_ALIGNED_SEQUENCE_LINE, gSequencesArray[i].name,
+							 multipleAlignment.rows + (size_t) i *
+													  (multipleAlignment.numOfCols + 1));
+		if(gOutputBuffer.size >= OUTPUT_FLUSH_SIZE)
+		{
+			flushOutput();
 		}
 	}
+	flushOutput();
+
+	freeMultipleAlignment(&multipleAlignment);
+	free(scores);
+	free(values);
+	free(sizes);
 }
 
 /**
@@ -625,10 +2495,6 @@ void printFinalResultsForFile(const int match, const int mismatch, const int gap
 int main(int argc, char *argv[])
 {
 	FILE *fp;
-	gSequencesArray = (Sequence*) calloc(sizeof(struct Sequence) * MAX_NUM_OF_SEQUENCES,
-										sizeof(struct Sequence));
-
-	nullPointerCheckerForAllocatedMemory(gSequencesArray);
 
 	fp = fopen(argv[INDEX_OF_FILE_PATH_ARGUMENT], READ_MODE);
 
@@ -642,7 +2508,16 @@ int main(int argc, char *argv[])
 		checkIfInteger(argv[l]);
 	}
 
-	parseFile(fp);
+	Options options = parseOptionalArguments(argc, argv);
+
+	if(options.useIndex)
+	{
+		loadSequencesWithIndex(fp, argv[INDEX_OF_FILE_PATH_ARGUMENT], options.selectedNames);
+	}
+	else
+	{
+		parseFile(fp);
+	}
 
 	checkNotEnoughSequences(gNumOfSequences, argv[INDEX_OF_FILE_PATH_ARGUMENT]);
 
@@ -650,19 +2525,70 @@ int main(int argc, char *argv[])
 	int mismatch = (int) strtol(argv[INDEX_OF_MISMATCH_ARGUMENT], NULL, BASE_OF_COUNTING);
 	int gap = (int) strtol(argv[INDEX_OF_GAP_ARGUMENT], NULL, BASE_OF_COUNTING);
 
-	printFinalResultsForFile(match, mismatch, gap);
+	Aligner* aligner = alignerAlloc(match, mismatch, gap);
+	nullPointerCheckerForAllocatedMemory(aligner);
+	if(options.matrixPath != NULL)
+	{
+		checkAlignStatus(alignerLoadMatrix(aligner, options.matrixPath), options.matrixPath);
+	}
 
-	//now we will free all the allocated memory we used in the heap:
-	int seq;
-	for(seq = 0 ; seq < gNumOfSequences ; seq++)
+	if(options.numOfShards != NO_SHARDS)
 	{
-		free(gSequencesArray[seq].value);
-		gSequencesArray[seq].value = NULL;
+		setPairsOfShard(options.shard, options.numOfShards);
+	}
+
+	if(options.checkpointPath != NULL)
+	{
+		openCheckpointFile(&options, calculateCheckpointFingerprint(match, mismatch, gap,
+																	&options));
+	}
+
+	if(options.editDistance)
+	{
+		checkValidEditDistance(options, match, mismatch, gap);
+		printEditDistancesForFile();
+	}
+	else if(options.multipleAlignment)
+	{
+		printMultipleAlignmentForFile(aligner, &options);
+	}
+	else
+	{
+		printFinalResultsForFile(aligner, &options, NULL);
+	}
+
+	if(options.printStats)
+	{
+		AlignerStats stats = alignerStats(aligner);
+		fprintf(stderr, PRINT_STATS_LINE, stats.numOfAlignments, stats.numOfAllocations,
+				stats.workspaceSize);
 	}
 
+	//now we will free all the allocated memory we used in the heap:
+	free(gResiduesArena.bytes);
+	gResiduesArena.bytes = NULL;
+
+	free(gNamesArena.bytes);
+	gNamesArena.bytes = NULL;
+
+	freeAligner(&aligner);
+
+	free(gOutputBuffer.bytes);
+	gOutputBuffer.bytes = NULL;
+
 	free(gSequencesArray);
 	gSequencesArray = NULL;
 
+	if(gCheckpointFile != NULL)
+	{
+		fclose(gCheckpointFile);
+		gCheckpointFile = NULL;
+	}
+	free(gPendingCheckpointRecords.bytes);
+	gPendingCheckpointRecords.bytes = NULL;
+	free(gCompletedPairs);
+	gCompletedPairs = NULL;
+
 	return 0;
 
 }
@@ -0,0 +1,197 @@
+//================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+//================================ Constants ====================================================
+#define MIN_NUMBER_OF_ARGS 2
+#define TRUE 1
+#define FALSE 0
+#define FIRST_SHARD_ARGUMENT_INDEX 1
+#define READ_MODE "r"
+#define NOT_FOUND -1
+#define COPY_BUFFER_SIZE 65536
+#define MAX_SIZE_OF_HEADER_LINE 64
+#define SHARD_HEADER_FORMAT "# shard %d/%d%n"
+#define NEW_LINE_CHAR '\n'
+#define TWO_NEW_LINES "\n\n"
+#define ARGS_ERROR "Error of usage: MergeShards <shard output> <shard output> ...\n"
+#define FILE_DOES_NOT_EXIST_ERROR "Error opening file: %s\n"
+#define INVALID_HEADER_ERROR "Error in shard output %s: it doesn't start with a shard header " \
+							 "line\n"
+#define DIFFERENT_NUM_OF_SHARDS_ERROR "Error in shard output %s: it's a shard of %d shards, not " \
+									  "of %d\n"
+#define DUPLICATE_SHARD_ERROR "Error in shard output %s: shard %d was already given by %s\n"
+#define MISSING_SHARD_ERROR "Error of usage: the output of shard %d/%d is missing\n"
+#define ERROR_NOT_ENOUGH_MEMORY "ERROR - Not enough memory!!!"
+
+//================================ Code Segment =================================================
+
+/**
+ * This function checks that a memory allocation succeeded, and exits with an error otherwise.
+ * @param p - the allocated memory.
+ */
+void nullPointerCheckerForAllocatedMemory(const void *p)
+{
+	if(p == NULL)
+	{
+		fprintf(stderr, ERROR_NOT_ENOUGH_MEMORY);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function opens a shard output, and exits with an error message if it can't be opened.
+ * @param filePath - the path of the shard output.
+ * @return the open file.
+ */
+FILE *openShardOutput(const char *filePath)
+{
+	FILE *fp = fopen(filePath, READ_MODE);
+	if(fp == NULL)
+	{
+		fprintf(stderr, FILE_DOES_NOT_EXIST_ERROR, filePath);
+		exit(EXIT_FAILURE);
+	}
+	return fp;
+}
+
+/**
+ * This function reads the header line of a shard output ("# shard <k>/<N>"), which is left right
+ * after it.
+ * @param fp - the shard output.
+ * @param filePath - the path of the shard output.
+ * @param shard - output: the shard (1 to numOfShards).
+ * @param numOfShards - output: the number of shards.
+ */
+void readShardHeader(FILE *fp, const char *filePath, int *shard, int *numOfShards)
+{
+	char line[MAX_SIZE_OF_HEADER_LINE];
+	int lineLen = 0;
+
+	if(fgets(line, sizeof(line), fp) == NULL ||
+	   sscanf(line, SHARD_HEADER_FORMAT, shard, numOfShards, &lineLen) != 2 ||
+	   line[lineLen] != NEW_LINE_CHAR || *numOfShards < 1 || *shard < 1 ||
+	   *shard > *numOfShards)
+	{
+		fprintf(stderr, INVALID_HEADER_ERROR, filePath);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function copies the results of a shard output (everything after its header line) to
+ * stdout. The results of every two pairs are separated by new lines, so the results of two
+ * shards which aren't empty are separated by new lines as well.
+ * @param fp - the shard output, right after its header line.
+ * @param buffer - the copy buffer.
+ * @param isFirstResult - TRUE if no results were copied yet, and is updated.
+ */
+void copyShardResults(FILE *fp, char *buffer, int *isFirstResult)
+{
+	size_t count = fread(buffer, sizeof(char), COPY_BUFFER_SIZE, fp);
+	if(count == 0)
+	{
+		return;
+	}
+
+	if(!*isFirstResult)
+	{
+		fputs(TWO_NEW_LINES, stdout);
+	}
+	*isFirstResult = FALSE;
+
+	do
+	{
+		fwrite(buffer, sizeof(char), count, stdout);
+		count = fread(buffer, sizeof(char), COPY_BUFFER_SIZE, fp);
+	} while(count > 0);
+}
+
+/**
+ * This is the main function of the merge tool. It gets the outputs of all the shards of a sharded
+ * CompareSequences run (--shard=<k>/<N>, in any order), and prints the results of all of them in
+ * the order of the shards, which is the output of a run with no shards.
+ * @param argc arguments counter.
+ * @param argv arguments values.
+ * @return 0 if succeeds, 1 otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	if(argc < MIN_NUMBER_OF_ARGS)
+	{
+		fprintf(stderr, ARGS_ERROR);
+		exit(EXIT_FAILURE);
+	}
+
+	int numOfFiles = argc - FIRST_SHARD_ARGUMENT_INDEX;
+	int numOfShards = 0;
+	int *fileOfShard = NULL;
+	int i;
+
+	//the files are in any order: the header line of each one tells its shard.
+	for(i = 0 ; i < numOfFiles ; i++)
+	{
+		const char *filePath = argv[FIRST_SHARD_ARGUMENT_INDEX + i];
+		FILE *fp = openShardOutput(filePath);
+		int shard;
+		int numOfShardsOfFile;
+		readShardHeader(fp, filePath, &shard, &numOfShardsOfFile);
+		fclose(fp);
+
+		if(fileOfShard == NULL)
+		{
+			numOfShards = numOfShardsOfFile;
+			fileOfShard = (int*) malloc((size_t) numOfShards * sizeof(int));
+			nullPointerCheckerForAllocatedMemory(fileOfShard);
+			int k;
+			for(k = 0 ; k < numOfShards ; k++)
+			{
+				fileOfShard[k] = NOT_FOUND;
+			}
+		}
+
+		if(numOfShardsOfFile != numOfShards)
+		{
+			fprintf(stderr, DIFFERENT_NUM_OF_SHARDS_ERROR, filePath, numOfShardsOfFile,
+					numOfShards);
+			exit(EXIT_FAILURE);
+		}
+		if(fileOfShard[shard - 1] != NOT_FOUND)
+		{
+			fprintf(stderr, DUPLICATE_SHARD_ERROR, filePath, shard,
+					argv[FIRST_SHARD_ARGUMENT_INDEX + fileOfShard[shard - 1]]);
+			exit(EXIT_FAILURE);
+		}
+		fileOfShard[shard - 1] = i;
+	}
+
+	for(i = 0 ; i < numOfShards ; i++)
+	{
+		if(fileOfShard[i] == NOT_FOUND)
+		{
+			fprintf(stderr, MISSING_SHARD_ERROR, i + 1, numOfShards);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	char *buffer = (char*) malloc(COPY_BUFFER_SIZE);
+	nullPointerCheckerForAllocatedMemory(buffer);
+	int isFirstResult = TRUE;
+
+	for(i = 0 ; i < numOfShards ; i++)
+	{
+		const char *filePath = argv[FIRST_SHARD_ARGUMENT_INDEX + fileOfShard[i]];
+		FILE *fp = openShardOutput(filePath);
+		int shard;
+		int numOfShardsOfFile;
+		readShardHeader(fp, filePath, &shard, &numOfShardsOfFile);
+		copyShardResults(fp, buffer, &isFirstResult);
+		fclose(fp);
+	}
+
+	free(buffer);
+	free(fileOfShard);
+
+	return 0;
+}
@@ -0,0 +1,1434 @@
+//================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
+#include "align.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+//================================ Constants ====================================================
+#define TRUE 1
+#define FALSE 0
+#define INDEX_OF_FIRST_ROW_OR_COLUMN 0
+#define BASE_OF_COUNTING 10
+#define EMPTY_CHAR '\0'
+#define READ_MODE "r"
+#define GROWTH_FACTOR 2
+#define INITIAL_WORKSPACE_CAPACITY 4096
+#define WORKSPACE_ALIGNMENT 64
+#define NUM_OF_RESIDUE_CODES 64
+#define NO_RESIDUE_CODE 0
+#define FIRST_UPPER_CASE_LETTER 'A'
+#define LAST_UPPER_CASE_LETTER 'Z'
+#define FIRST_LOWER_CASE_LETTER 'a'
+#define LAST_LOWER_CASE_LETTER 'z'
+#define FIRST_UPPER_CASE_CODE 1
+#define FIRST_LOWER_CASE_CODE 27
+#define FIRST_CHAR_OF_COMMENT_LINE '#'
+#define MAX_SIZE_OF_MATRIX_LINE 1024
+#define MATRIX_SEPARATORS " \t\r\n"
+#define NEGATIVE_INFINITY_SCORE (INT_MIN / 2)
+#define TYPE_OF_DIAGONAL 'd'
+#define TYPE_OF_FIRST_CELL 'f'
+#define GAP_CODE 0
+#define PROFILE_SCORE_SCALE 100
+#define CIGAR_MATCH 'M'
+#define CIGAR_INSERTION 'I'
+#define CIGAR_DELETION 'D'
+#define CIGAR_RUN_FORMAT "%d%c"
+#define SUCCESS_MESSAGE "Success"
+#define NO_MEMORY_MESSAGE "Not enough memory"
+#define INVALID_ARGUMENT_MESSAGE "Invalid argument"
+#define INVALID_RESIDUE_MESSAGE "A sequence has a residue which is not a letter"
+#define FILE_NOT_FOUND_MESSAGE "File not found"
+#define INVALID_MATRIX_FILE_MESSAGE "Invalid substitution matrix file"
+#define UNKNOWN_STATUS_MESSAGE "Unknown status"
+
+//================================ Code Segment =================================================
+
+/**
+ * This struct represents a cell of the scores matrix: its score, and the type of the cell it came
+ * from, which is enough for a traceback to find that cell (the cell before a diagonal is one row
+ * and one column back, before a gap in string 1 one column back, and before a gap in string 2 one
+ * row back) - so a cell has no pointer, and takes 8 bytes.
+ */
+typedef struct CellOfScoresMatrix
+{
+	int value;
+	char typeOfPrevCell;
+} CellOfScoresMatrix;
+
+/**
+ * This struct represents an aligner: its scores, its statistics, and one contiguous workspace,
+ * which only grows, so after the first few alignments there are no more allocations. The
+ * workspace holds (each part 64 bytes aligned) the encoded strings, the columns and the CIGAR
+ * string of the last alignment, and the cells of its scores matrix, row after row.
+ */
+struct Aligner
+{
+	int gap;
+	int substitutionTable[NUM_OF_RESIDUE_CODES][NUM_OF_RESIDUE_CODES];
+	int maxSubstitutionScore;   // for bounding the score of alignments outside of a band.
+	char *workspace;
+	size_t workspaceCapacity;
+	char *encodedStrings;   // both strings encoded, each one null terminated.
+	char *columns;
+	char *cigar;
+	CellOfScoresMatrix *cells;
+	size_t cellsOffset;   // the offset of the cells in the workspace.
+	char *extra;   // the part after the cells, for the column scores of profile alignments.
+	AlignerStats stats;
+};
+
+/**
+ * This struct represents the data a profile alignment scores its columns by, which lives in the
+ * extra part of the workspace. A gap has the code GAP_CODE: a residue against a gap scores the gap
+ * score, and a gap against a gap scores 0.
+ */
+typedef struct ProfileScores
+{
+	int *weights1;   // weights1[i * NUM_OF_RESIDUE_CODES + b] = the score of code b against the
+					 // whole column i of profile 1.
+	int *gapCosts1;   // the cost of a gap in profile 1 against column j of profile 2 (scaled).
+	int *gapCosts2;   // the cost of a gap in profile 2 against column i of profile 1 (scaled).
+	int *offsets2;   // the codes of column j of profile 2 are at offsets2[j] - offsets2[j + 1].
+	int *codes2;
+	int *counts2;
+	long long numOfPairs;   // the number of pairs of rows, which the scores are averaged over.
+} ProfileScores;
+
+/**
+ * This function rounds a size up to a multiple of the workspace alignment.
+ * @param size - the size.
+ * @return the rounded size.
+ */
+static size_t alignedSize(const size_t size)
+{
+	return (size + WORKSPACE_ALIGNMENT - 1) / WORKSPACE_ALIGNMENT * WORKSPACE_ALIGNMENT;
+}
+
+/**
+ * This function grows the capacity of the workspace of an aligner (geometrically) until it has
+ * room for at least minCapacity bytes. A grown workspace is a new 64 bytes aligned block, which
+ * keeps the first sizeToKeep bytes of the old one.
+ * @param aligner - the aligner.
+ * @param minCapacity - the minimal capacity the workspace needs.
+ * @param sizeToKeep - the number of bytes from the start of the workspace to keep.
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_NO_MEMORY.
+ */
+static AlignStatus reserveWorkspace(Aligner* aligner, const size_t minCapacity,
+									const size_t sizeToKeep)
+{
+	if(aligner->workspaceCapacity >= minCapacity)
+	{
+		return ALIGN_SUCCESS;
+	}
+
+	size_t newCapacity = (aligner->workspaceCapacity > 0) ? aligner->workspaceCapacity :
+						 INITIAL_WORKSPACE_CAPACITY;
+
+	while(newCapacity < minCapacity)
+	{
+		if(newCapacity > SIZE_MAX / GROWTH_FACTOR)
+		{
+			newCapacity = minCapacity;
+			break;
+		}
+		newCapacity *= GROWTH_FACTOR;
+	}
+
+	void *newWorkspace = NULL;
+	if(posix_memalign(&newWorkspace, WORKSPACE_ALIGNMENT, newCapacity) != 0)
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	if(sizeToKeep > 0)
+	{
+		memcpy(newWorkspace, aligner->workspace, sizeToKeep);
+	}
+	free(aligner->workspace);
+
+	aligner->workspace = (char*) newWorkspace;
+	aligner->workspaceCapacity = newCapacity;
+	aligner->stats.numOfAllocations++;
+	aligner->stats.workspaceSize = newCapacity;
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function reserves the workspace of an aligner for the alignment of two strings, and sets
+ * the locations of the parts of the workspace. The cells part has room for numOfCells cells,
+ * and the extra part after it has room for extraSize bytes.
+ * @param aligner - the aligner.
+ * @param sizeStr1 - the size of input string 1.
+ * @param sizeStr2 - the size of input string 2.
+ * @param numOfCells - the number of cells the scores matrix needs.
+ * @param extraSize - the size of the extra part.
+ * @param keepStrings - TRUE to keep the encoded strings (and everything before the cells).
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_NO_MEMORY.
+ */
+static AlignStatus reserveWorkspaceForAlignment(Aligner* aligner, const int sizeStr1,
+												const int sizeStr2, const size_t numOfCells,
+												const size_t extraSize, const int keepStrings)
+{
+	size_t sizeOfStrings = (size_t) sizeStr1 + (size_t) sizeStr2;
+	//an alignment has at most one column for every residue of both strings, and every run of
+	//CIGAR_RUN_FORMAT takes at most 2 chars for every column in it.
+	size_t cellsOffset = alignedSize(sizeOfStrings + 2) + alignedSize(sizeOfStrings) +
+						 alignedSize(2 * sizeOfStrings + 1);
+
+	if(numOfCells > (SIZE_MAX - cellsOffset - extraSize - WORKSPACE_ALIGNMENT) /
+					sizeof(CellOfScoresMatrix))
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	size_t extraOffset = cellsOffset + alignedSize(numOfCells * sizeof(CellOfScoresMatrix));
+	if(reserveWorkspace(aligner, extraOffset + extraSize,
+						keepStrings ? cellsOffset : 0) != ALIGN_SUCCESS)
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	aligner->encodedStrings = aligner->workspace;
+	aligner->columns = aligner->encodedStrings + alignedSize(sizeOfStrings + 2);
+	aligner->cigar = aligner->columns + alignedSize(sizeOfStrings);
+	aligner->cells = (CellOfScoresMatrix*) (aligner->workspace + cellsOffset);
+	aligner->cellsOffset = cellsOffset;
+	aligner->extra = aligner->workspace + extraOffset;
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function encodes a residue letter into a small integer code: 'A'-'Z' get the codes 1-26
+ * and 'a'-'z' get the codes 27-52 (upper and lower case letters get different codes, and 0 is
+ * never a residue code).
+ * @param c - the residue letter.
+ * @return the residue code, or NO_RESIDUE_CODE if c is not a letter.
+ */
+static char encodeResidue(const char c)
+{
+	if(c >= FIRST_UPPER_CASE_LETTER && c <= LAST_UPPER_CASE_LETTER)
+	{
+		return (char) (c - FIRST_UPPER_CASE_LETTER + FIRST_UPPER_CASE_CODE);
+	}
+	if(c >= FIRST_LOWER_CASE_LETTER && c <= LAST_LOWER_CASE_LETTER)
+	{
+		return (char) (c - FIRST_LOWER_CASE_LETTER + FIRST_LOWER_CASE_CODE);
+	}
+	return NO_RESIDUE_CODE;
+}
+
+/**
+ * This function fills the substitution table with the match score for identical residues and
+ * the mismatch score for different residues.
+ * @param substitutionTable - the substitution table.
+ * @param match - the score for match argument.
+ * @param mismatch - the score for mismatch argument.
+ */
+static void fillSubstitutionTable(int substitutionTable[][NUM_OF_RESIDUE_CODES], const int match,
+								  const int mismatch)
+{
+	int a;
+	int b;
+
+	for(a = 0 ; a < NUM_OF_RESIDUE_CODES ; a++)
+	{
+		for(b = 0 ; b < NUM_OF_RESIDUE_CODES ; b++)
+		{
+			substitutionTable[a][b] = (a == b) ? match : mismatch;
+		}
+	}
+}
+
+/**
+ * This function calculates the maximal score in a substitution table over all residue codes.
+ * @param substitutionTable - the substitution table.
+ * @return the maximal substitution score.
+ */
+static int calculateMaxSubstitutionScore(int substitutionTable[][NUM_OF_RESIDUE_CODES])
+{
+	int lastCode = encodeResidue(LAST_LOWER_CASE_LETTER);
+	int maxScore = INT_MIN;
+	int a;
+	int b;
+
+	for(a = NO_RESIDUE_CODE + 1 ; a <= lastCode ; a++)
+	{
+		for(b = NO_RESIDUE_CODE + 1 ; b <= lastCode ; b++)
+		{
+			if(substitutionTable[a][b] > maxScore)
+			{
+				maxScore = substitutionTable[a][b];
+			}
+		}
+	}
+
+	return maxScore;
+}
+
+/**
+ * This function allocates a new aligner, whose substitution table gives the match score for
+ * identical residues and the mismatch score for different residues.
+ * @param match - the score for match argument.
+ * @param mismatch - the score for mismatch argument.
+ * @param gap - the score for gap argument.
+ * @return the new aligner, or NULL if there's not enough memory.
+ */
+Aligner* alignerAlloc(int match, int mismatch, int gap)
+{
+	Aligner* aligner = (Aligner*) calloc(1, sizeof(Aligner));
+	if(aligner == NULL)
+	{
+		return NULL;
+	}
+
+	aligner->gap = gap;
+	fillSubstitutionTable(aligner->substitutionTable, match, mismatch);
+	aligner->maxSubstitutionScore = calculateMaxSubstitutionScore(aligner->substitutionTable);
+
+	return aligner;
+}
+
+/**
+ * This function frees an aligner and its workspace.
+ * @param aligner - a pointer to the aligner, which is set to NULL.
+ */
+void freeAligner(Aligner** aligner)
+{
+	if(*aligner == NULL)
+	{
+		return;
+	}
+
+	free((*aligner)->workspace);
+	free(*aligner);
+	*aligner = NULL;
+}
+
+/**
+ * This function returns the statistics of an aligner: the number of alignments it calculated,
+ * and the number of allocations and the size of its workspace.
+ * @param aligner - the aligner.
+ * @return the statistics.
+ */
+AlignerStats alignerStats(const Aligner* aligner)
+{
+	return aligner->stats;
+}
+
+/**
+ * This function allocates a new aligner with the scores of another aligner, and an empty
+ * workspace of its own, so the two can be used by two threads at the same time.
+ * @param aligner - the aligner to clone.
+ * @return the new aligner, or NULL if there's not enough memory.
+ */
+Aligner* alignerClone(const Aligner* aligner)
+{
+	Aligner* clone = (Aligner*) calloc(1, sizeof(Aligner));
+	if(clone == NULL)
+	{
+		return NULL;
+	}
+
+	clone->gap = aligner->gap;
+	memcpy(clone->substitutionTable, aligner->substitutionTable,
+		   sizeof(aligner->substitutionTable));
+	clone->maxSubstitutionScore = aligner->maxSubstitutionScore;
+
+	return clone;
+}
+
+/**
+ * This function sets the substitution score of two residue letters, for both of their cases.
+ * @param substitutionTable - the substitution table.
+ * @param rowLetter - the first residue letter.
+ * @param colLetter - the second residue letter.
+ * @param score - the score of aligning them.
+ */
+static void setSubstitutionScore(int substitutionTable[][NUM_OF_RESIDUE_CODES],
+								 const char rowLetter, const char colLetter, const int score)
+{
+	int rowCodes[] = {encodeResidue((char) toupper((unsigned char) rowLetter)),
+					  encodeResidue((char) tolower((unsigned char) rowLetter))};
+	int colCodes[] = {encodeResidue((char) toupper((unsigned char) colLetter)),
+					  encodeResidue((char) tolower((unsigned char) colLetter))};
+	int i;
+	int j;
+
+	for(i = 0 ; i < 2 ; i++)
+	{
+		for(j = 0 ; j < 2 ; j++)
+		{
+			substitutionTable[rowCodes[i]][colCodes[j]] = score;
+		}
+	}
+}
+
+/**
+ * This function parses one line of a substitution matrix file into a substitution table. The
+ * first line (when there are no column letters yet) holds the column letters, and every other
+ * line holds a row letter and its scores.
+ * @param line - the line (it's changed by the parsing).
+ * @param colLetters - the column letters.
+ * @param numOfCols - the number of column letters.
+ * @param substitutionTable - the substitution table.
+ * @return TRUE if the line is valid, FALSE otherwise.
+ */
+static int parseMatrixLine(char *line, char *colLetters, int *numOfCols,
+						   int substitutionTable[][NUM_OF_RESIDUE_CODES])
+{
+	char *savePointer = NULL;
+	char *token = strtok_r(line, MATRIX_SEPARATORS, &savePointer);
+
+	if(token == NULL || token[0] == FIRST_CHAR_OF_COMMENT_LINE)
+	{
+		return TRUE;
+	}
+
+	if(*numOfCols == 0)
+	{
+		while(token != NULL)
+		{
+			if(strlen(token) != 1 || *numOfCols >= NUM_OF_RESIDUE_CODES)
+			{
+				return FALSE;
+			}
+			colLetters[*numOfCols] = token[0];
+			(*numOfCols)++;
+			token = strtok_r(NULL, MATRIX_SEPARATORS, &savePointer);
+		}
+		return TRUE;
+	}
+
+	if(strlen(token) != 1)
+	{
+		return FALSE;
+	}
+
+	char rowLetter = token[0];
+	int col;
+
+	for(col = 0 ; col < *numOfCols ; col++)
+	{
+		token = strtok_r(NULL, MATRIX_SEPARATORS, &savePointer);
+		if(token == NULL)
+		{
+			return FALSE;
+		}
+
+		char *end = NULL;
+		int score = (int) strtol(token, &end, BASE_OF_COUNTING);
+		if(*end != EMPTY_CHAR)
+		{
+			return FALSE;
+		}
+
+		if(isalpha((unsigned char) rowLetter) && isalpha((unsigned char) colLetters[col]))
+		{
+			setSubstitutionScore(substitutionTable, rowLetter, colLetters[col], score);
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * This function loads a substitution matrix file in the standard (NCBI BLOSUM / PAM) format
+ * into the substitution table of an aligner: '#' lines are comments, the first other line holds
+ * the column letters, and every following line holds a row letter and its scores. Non letter rows
+ * and columns (like '*') are ignored, and pairs of letters missing from the file keep their
+ * match / mismatch scores. If the file is not valid, the aligner is not changed.
+ * @param aligner - the aligner.
+ * @param filePath - the path of the substitution matrix file.
+ * @return ALIGN_SUCCESS, ALIGN_ERROR_FILE_NOT_FOUND or ALIGN_ERROR_INVALID_MATRIX_FILE.
+ */
+AlignStatus alignerLoadMatrix(Aligner* aligner, const char *filePath)
+{
+	if(aligner == NULL || filePath == NULL)
+	{
+		return ALIGN_ERROR_INVALID_ARGUMENT;
+	}
+
+	FILE *fp = fopen(filePath, READ_MODE);
+	if(fp == NULL)
+	{
+		return ALIGN_ERROR_FILE_NOT_FOUND;
+	}
+
+	int substitutionTable[NUM_OF_RESIDUE_CODES][NUM_OF_RESIDUE_CODES];
+	char line[MAX_SIZE_OF_MATRIX_LINE] = {EMPTY_CHAR};
+	char colLetters[NUM_OF_RESIDUE_CODES] = {EMPTY_CHAR};
+	int numOfCols = 0;
+	int isValid = TRUE;
+
+	memcpy(substitutionTable, aligner->substitutionTable, sizeof(substitutionTable));
+
+	while(isValid && fgets(line, MAX_SIZE_OF_MATRIX_LINE, fp) != NULL)
+	{
+		isValid = parseMatrixLine(line, colLetters, &numOfCols, substitutionTable);
+	}
+
+	fclose(fp);
+
+	if(!isValid || numOfCols == 0)
+	{
+		return ALIGN_ERROR_INVALID_MATRIX_FILE;
+	}
+
+	memcpy(aligner->substitutionTable, substitutionTable, sizeof(substitutionTable));
+	aligner->maxSubstitutionScore = calculateMaxSubstitutionScore(aligner->substitutionTable);
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function calculates the maximum integer from three input integers x, y, z.
+ * @param x - integer 1.
+ * @param y - integer 2.
+ * @param z - integer 3.
+ * @return the maximum of the three.
+ */
+static int maxOfThreeCalculator(const int x, const int y, const int z)
+{
+	if(x > y)
+	{
+		if(x > z)
+		{
+			return x;
+		}
+		else
+		{
+			return z;
+		}
+
+	}
+	else
+	{
+		if(y > z)
+		{
+			return y;
+		}
+		else
+		{
+			return z;
+		}
+	}
+}
+
+/**
+ * This function initializes the first row and the first column of the scores matrix. Every
+ * boundary cell gets the value (index * boundaryGap), and comes from the previous cell along the
+ * boundary if boundaryIsPath is TRUE, or is marked as a first cell (where a traceback stops)
+ * otherwise.
+ * @param scoresMatrix - the scores matrix, row after row.
+ * @param sizeStr1Rows - the size of input string 1.
+ * @param sizeStr2Cols - the size of input string 2.
+ * @param boundaryGap - the score for every gap on the boundary (gap, or 0 for free end gaps).
+ * @param boundaryIsPath - TRUE if a traceback may continue along the boundary, FALSE otherwise.
+ */
+static void initializeFirstRowAndColumn(CellOfScoresMatrix *scoresMatrix, const int sizeStr1Rows,
+										const int sizeStr2Cols, const int boundaryGap,
+										const int boundaryIsPath)
+{
+	size_t numOfCols = (size_t) sizeStr2Cols + 1;
+	int j;
+	for(j = 0; j < sizeStr1Rows + 1 ; j++)
+	{
+		CellOfScoresMatrix *cell = &scoresMatrix[(size_t) j * numOfCols +
+												 INDEX_OF_FIRST_ROW_OR_COLUMN];
+		cell->value = j * boundaryGap;
+		cell->typeOfPrevCell = (j == 0 || !boundaryIsPath) ? TYPE_OF_FIRST_CELL :
+							   TYPE_OF_GAP_IN_STR2;
+	}
+	for(j = 0 ; j < sizeStr2Cols + 1 ; j++)
+	{
+		CellOfScoresMatrix *cell = &scoresMatrix[INDEX_OF_FIRST_ROW_OR_COLUMN * numOfCols + j];
+		cell->value = j * boundaryGap;
+		cell->typeOfPrevCell = (j == 0 || !boundaryIsPath) ? TYPE_OF_FIRST_CELL :
+							   TYPE_OF_GAP_IN_STR1;
+	}
+}
+
+/**
+ * This function finds the end cell of a semi-global alignment, which is the best cell of the
+ * last row or the last column of the scores matrix (gaps after it are free).
+ * @param scoresMatrix - the filled scores matrix, row after row.
+ * @param sizeStr1Rows - the size of input string 1.
+ * @param sizeStr2Cols - the size of input string 2.
+ * @param bestRow - output: the row of the end cell.
+ * @param bestCol - output: the column of the end cell.
+ */
+static void findSemiGlobalEndCell(const CellOfScoresMatrix *scoresMatrix, const int sizeStr1Rows,
+								  const int sizeStr2Cols, int *bestRow, int *bestCol)
+{
+	size_t numOfCols = (size_t) sizeStr2Cols + 1;
+	const CellOfScoresMatrix *lastRow = scoresMatrix + (size_t) sizeStr1Rows * numOfCols;
+	int bestValue = lastRow[sizeStr2Cols].value;
+	int i;
+	int j;
+
+	*bestRow = sizeStr1Rows;
+	*bestCol = sizeStr2Cols;
+
+	for(j = 0 ; j < sizeStr2Cols ; j++)
+	{
+		if(lastRow[j].value > bestValue)
+		{
+			bestValue = lastRow[j].value;
+			*bestRow = sizeStr1Rows;
+			*bestCol = j;
+		}
+	}
+
+	for(i = 0 ; i < sizeStr1Rows ; i++)
+	{
+		if(scoresMatrix[(size_t) i * numOfCols + sizeStr2Cols].value > bestValue)
+		{
+			bestValue = scoresMatrix[(size_t) i * numOfCols + sizeStr2Cols].value;
+			*bestRow = i;
+			*bestCol = sizeStr2Cols;
+		}
+	}
+}
+
+/**
+ * This macro defines a function which fills the scores matrix for one alignment mode. All the
+ * modes share the same recurrence, and differ only in the macro parameters, which are compile
+ * time constants - so the compiler removes the branches of the other modes from the inner loop:
+ * @param functionName - the name of the defined function.
+ * @param boundaryGap - the score of a gap on the first row / column (gap, or 0 for free gaps).
+ * @param boundaryIsPath - TRUE if a traceback may continue along the first row / column.
+ * @param isLocal - TRUE for local alignment: cells never drop below 0, where a traceback stops,
+ *                  and the end cell is the best cell of the whole matrix.
+ * @param isSemiGlobal - TRUE if the end cell is the best cell of the last row or column.
+ * The defined function gets the aligner, the scores matrix (row after row), the two encoded
+ * strings and their sizes, and returns the end cell of the best alignment in bestRow, bestCol.
+ */
+#define DEFINE_SCORES_MATRIX_FILLER(functionName, boundaryGap, boundaryIsPath, isLocal,          \
+									isSemiGlobal)                                                \
+static void functionName(const Aligner* aligner, CellOfScoresMatrix *scoresMatrix,              \
+						 const char *str1Rows, const char *str2Cols, const int sizeStr1Rows,    \
+						 const int sizeStr2Cols, int *bestRow, int *bestCol)                   \
+{                                                                                                \
+	const int gap = aligner->gap;                                                                \
+	const size_t numOfCols = (size_t) sizeStr2Cols + 1;                                          \
+	int i;                                                                                       \
+	int j;                                                                                       \
+	int bestValue = 0;                                                                           \
+	*bestRow = sizeStr1Rows;                                                                     \
+	*bestCol = sizeStr2Cols;                                                                     \
+	if(isLocal)                                                                                  \
+	{                                                                                            \
+		*bestRow = INDEX_OF_FIRST_ROW_OR_COLUMN;                                                 \
+		*bestCol = INDEX_OF_FIRST_ROW_OR_COLUMN;                                                 \
+	}                                                                                            \
+	initializeFirstRowAndColumn(scoresMatrix, sizeStr1Rows, sizeStr2Cols, boundaryGap,           \
+								boundaryIsPath);                                                 \
+	for(i = 0; i < sizeStr1Rows ; i++)                                                           \
+	{                                                                                            \
+		const int *substitutionRow = aligner->substitutionTable[(unsigned char) str1Rows[i]];   \
+		const CellOfScoresMatrix *prevRow = scoresMatrix + (size_t) i * numOfCols;               \
+		CellOfScoresMatrix *row = scoresMatrix + (size_t) (i + 1) * numOfCols;                   \
+		for(j = 0 ; j < sizeStr2Cols ; j++)                                                      \
+		{                                                                                        \
+			CellOfScoresMatrix *cell = &row[j + 1];                                              \
+			int diagonalResult = prevRow[j].value + substitutionRow[(unsigned char) str2Cols[j]];\
+			int gapResult1 = prevRow[j + 1].value + gap;                                         \
+			int gapResult2 = row[j].value + gap;                                                 \
+			int result = maxOfThreeCalculator(diagonalResult, gapResult1, gapResult2);           \
+			if(result == diagonalResult)                                                         \
+			{                                                                                    \
+				cell->typeOfPrevCell = TYPE_OF_DIAGONAL;                                         \
+			}                                                                                    \
+			else if(result == gapResult1)                                                        \
+			{                                                                                    \
+				cell->typeOfPrevCell = TYPE_OF_GAP_IN_STR2;                                      \
+			}                                                                                    \
+			else                                                                                 \
+			{                                                                                    \
+				cell->typeOfPrevCell = TYPE_OF_GAP_IN_STR1;                                      \
+			}                                                                                    \
+			if(isLocal && result <= 0)                                                           \
+			{                                                                                    \
+				result = 0;                                                                      \
+				cell->typeOfPrevCell = TYPE_OF_FIRST_CELL;                                       \
+			}                                                                                    \
+			if(isLocal && result > bestValue)                                                    \
+			{                                                                                    \
+				bestValue = result;                                                              \
+				*bestRow = i + 1;                                                                \
+				*bestCol = j + 1;                                                                \
+			}                                                                                    \
+			cell->value = result;                                                                \
+		}                                                                                        \
+	}                                                                                            \
+	if(isSemiGlobal)                                                                             \
+	{                                                                                            \
+		findSemiGlobalEndCell(scoresMatrix, sizeStr1Rows, sizeStr2Cols, bestRow, bestCol);       \
+	}                                                                                            \
+}
+
+DEFINE_SCORES_MATRIX_FILLER(fillScoresMatrixGlobal, gap, TRUE, FALSE, FALSE)
+DEFINE_SCORES_MATRIX_FILLER(fillScoresMatrixLocal, 0, FALSE, TRUE, FALSE)
+DEFINE_SCORES_MATRIX_FILLER(fillScoresMatrixSemiGlobal, 0, TRUE, FALSE, TRUE)
+
+/**
+ * This function adds count copies of a given type to the columns of an alignment, before its
+ * current first column.
+ * @param firstColumn - the first column of the alignment, which is moved back.
+ * @param type - the type to add.
+ * @param count - the number of copies to add.
+ */
+static void addTypeToColumns(char **firstColumn, const char type, const int count)
+{
+	int k;
+	for(k = 0 ; k < count ; k++)
+	{
+		(*firstColumn)--;
+		**firstColumn = type;
+	}
+}
+
+/**
+ * This function restores the best alignment from its end cell back to the cell it starts from,
+ * and saves the location where the alignment starts in each string. Cell (row, col) of the scores
+ * matrix is at cells[row * rowStride + col + colOffset], so the same traceback serves the full
+ * matrix and the band. The types are written back to front into the end of the columns part of
+ * the workspace (which has room for a column for every residue of both strings), so the columns
+ * end up in order, with no reversal pass.
+ * @param aligner - the aligner.
+ * @param cells - the cells of the filled scores matrix.
+ * @param rowStride - the distance between the cells of two following rows in the same column.
+ * @param colOffset - the offset of the cells of column 0.
+ * @param endRow - the row of the end cell of the alignment.
+ * @param endCol - the column of the end cell of the alignment.
+ * @param sizeStr1Rows - the size of input string 1.
+ * @param sizeStr2Cols - the size of input string 2.
+ * @param withEndGaps - TRUE if the rest of the strings after the end cell should be restored as
+ *                      (free) gaps, FALSE otherwise.
+ * @param compareResidues - TRUE if a diagonal is a match or a mismatch by the encoded strings,
+ *                          FALSE if it's always a match (the columns of two profiles).
+ * @param alignment - output: the alignment.
+ */
+static void traceBackAlignment(const Aligner* aligner, const CellOfScoresMatrix *cells,
+							   const ptrdiff_t rowStride, const ptrdiff_t colOffset, int endRow,
+							   int endCol, const int sizeStr1Rows, const int sizeStr2Cols,
+							   const int withEndGaps, const int compareResidues,
+							   Alignment *alignment)
+{
+	const char *str1Rows = aligner->encodedStrings;
+	const char *str2Cols = aligner->encodedStrings + sizeStr1Rows + 1;
+	char *columnsEnd = aligner->columns + sizeStr1Rows + sizeStr2Cols;
+	char *firstColumn = columnsEnd;
+
+	if(withEndGaps)
+	{
+		addTypeToColumns(&firstColumn, TYPE_OF_GAP_IN_STR1, sizeStr2Cols - endCol);
+		addTypeToColumns(&firstColumn, TYPE_OF_GAP_IN_STR2, sizeStr1Rows - endRow);
+	}
+
+	const CellOfScoresMatrix *tempCell = &cells[endRow * rowStride + endCol + colOffset];
+	alignment->score = tempCell->value;
+
+	while(tempCell->typeOfPrevCell != TYPE_OF_FIRST_CELL)
+	{
+		firstColumn--;
+		*firstColumn = tempCell->typeOfPrevCell;
+		if(tempCell->typeOfPrevCell == TYPE_OF_DIAGONAL)
+		{
+			*firstColumn = (!compareResidues || str1Rows[endRow - 1] == str2Cols[endCol - 1]) ?
+						   TYPE_OF_MATCH : TYPE_OF_MISMATCH;
+		}
+
+		if(tempCell->typeOfPrevCell != TYPE_OF_GAP_IN_STR1)
+		{
+			endRow--;
+		}
+		if(tempCell->typeOfPrevCell != TYPE_OF_GAP_IN_STR2)
+		{
+			endCol--;
+		}
+
+		tempCell = &cells[endRow * rowStride + endCol + colOffset];
+	}
+
+	alignment->columns = firstColumn;
+	alignment->numOfColumns = (int) (columnsEnd - firstColumn);
+	alignment->startInStr1 = endRow;
+	alignment->startInStr2 = endCol;
+}
+
+/**
+ * This function calculates the best alignment of the two encoded strings in the workspace of the
+ * aligner, scoring every pair of residues by the substitution table. The scores matrix is laid
+ * out row after row in the cells part of the workspace, which was reserved for it.
+ * @param aligner - the aligner.
+ * @param sizeStr1Rows - the size of input string 1.
+ * @param sizeStr2Cols - the size of input string 2.
+ * @param mode - the alignment mode (global, local or semi-global).
+ * @param alignment - output: the alignment.
+ */
+static void calculateBestAlignment(const Aligner* aligner, const int sizeStr1Rows,
+								   const int sizeStr2Cols, const AlignmentMode mode,
+								   Alignment *alignment)
+{
+	const char *str1Rows = aligner->encodedStrings;
+	const char *str2Cols = aligner->encodedStrings + sizeStr1Rows + 1;
+	int endRow;
+	int endCol;
+
+	if(mode == LOCAL_ALIGNMENT)
+	{
+		fillScoresMatrixLocal(aligner, aligner->cells, str1Rows, str2Cols, sizeStr1Rows,
+							  sizeStr2Cols, &endRow, &endCol);
+	}
+	else if(mode == SEMI_GLOBAL_ALIGNMENT)
+	{
+		fillScoresMatrixSemiGlobal(aligner, aligner->cells, str1Rows, str2Cols, sizeStr1Rows,
+								   sizeStr2Cols, &endRow, &endCol);
+	}
+	else
+	{
+		fillScoresMatrixGlobal(aligner, aligner->cells, str1Rows, str2Cols, sizeStr1Rows,
+							   sizeStr2Cols, &endRow, &endCol);
+	}
+
+	traceBackAlignment(aligner, aligner->cells, (ptrdiff_t) sizeStr2Cols + 1, 0, endRow, endCol,
+					   sizeStr1Rows, sizeStr2Cols, mode == SEMI_GLOBAL_ALIGNMENT, TRUE,
+					   alignment);
+}
+
+/**
+ * This function fills the cells of the scores matrix of a global alignment which are inside the
+ * band of diagonals (column - row) from lowDiagonal to highDiagonal. The band is stored row by
+ * row, where cell (i, j) is at bandMatrix[i * bandWidth + (j - i - lowDiagonal)], and cells
+ * outside of the band are never used.
+ * @param aligner - the aligner.
+ * @param bandMatrix - the band of the scores matrix.
+ * @param str1Rows - input string 1 (encoded).
+ * @param str2Cols - input string 2 (encoded).
+ * @param sizeStr1Rows - the size of input string 1.
+ * @param sizeStr2Cols - the size of input string 2.
+ * @param lowDiagonal - the lowest diagonal in the band.
+ * @param highDiagonal - the highest diagonal in the band.
+ */
+static void fillBandedScoresMatrix(const Aligner* aligner, CellOfScoresMatrix *bandMatrix,
+								   const char *str1Rows, const char *str2Cols,
+								   const int sizeStr1Rows, const int sizeStr2Cols,
+								   const int lowDiagonal, const int highDiagonal)
+{
+	const int gap = aligner->gap;
+	int bandWidth = highDiagonal - lowDiagonal + 1;
+	int i;
+	int j;
+
+	for(i = 0 ; i <= sizeStr1Rows ; i++)
+	{
+		int firstCol = (i + lowDiagonal > 0) ? i + lowDiagonal : 0;
+		int lastCol = (i + highDiagonal < sizeStr2Cols) ? i + highDiagonal : sizeStr2Cols;
+		//row[j] is the cell (i, j), and since the rows are shifted by one diagonal, prevRow[j] is
+		//the cell (i - 1, j - 1).
+		CellOfScoresMatrix *row = bandMatrix + (ptrdiff_t) i * (bandWidth - 1) - lowDiagonal;
+		CellOfScoresMatrix *prevRow = row - bandWidth;
+		const int *substitutionRow = (i > 0) ?
+									 aligner->substitutionTable[(unsigned char) str1Rows[i - 1]] :
+									 NULL;
+
+		for(j = firstCol ; j <= lastCol ; j++)
+		{
+			CellOfScoresMatrix *cell = &row[j];
+
+			if(i == 0 && j == 0)
+			{
+				cell->value = 0;
+				cell->typeOfPrevCell = TYPE_OF_FIRST_CELL;
+				continue;
+			}
+			if(i == 0)
+			{
+				cell->value = j * gap;
+				cell->typeOfPrevCell = TYPE_OF_GAP_IN_STR1;
+				continue;
+			}
+			if(j == 0)
+			{
+				cell->value = i * gap;
+				cell->typeOfPrevCell = TYPE_OF_GAP_IN_STR2;
+				continue;
+			}
+
+			//the cell above is in the band only if j - i + 1 <= highDiagonal, and the cell to the
+			//left only if j - 1 >= firstCol.
+			int diagonalResult = prevRow[j].value +
+								 substitutionRow[(unsigned char) str2Cols[j - 1]];
+			int gapResult1 = (j - i + 1 <= highDiagonal) ? prevRow[j + 1].value + gap :
+														   NEGATIVE_INFINITY_SCORE;
+			int gapResult2 = (j > firstCol) ? row[j - 1].value + gap : NEGATIVE_INFINITY_SCORE;
+			int result = maxOfThreeCalculator(diagonalResult, gapResult1, gapResult2);
+
+			if(result == diagonalResult)
+			{
+				cell->typeOfPrevCell = TYPE_OF_DIAGONAL;
+			}
+			else if(result == gapResult1)
+			{
+				cell->typeOfPrevCell = TYPE_OF_GAP_IN_STR2;
+			}
+			else
+			{
+				cell->typeOfPrevCell = TYPE_OF_GAP_IN_STR1;
+			}
+			cell->value = result;
+		}
+	}
+}
+
+/**
+ * This function calculates an upper bound for the score of every global alignment which leaves
+ * the band of diagonals from lowDiagonal to highDiagonal. Such an alignment has at least
+ * |sizeStr2Cols - sizeStr1Rows| + 2 * (band + 1) gaps, and every other column of it scores at
+ * most the maximal substitution score.
+ * @param aligner - the aligner.
+ * @param sizeStr1Rows - the size of input string 1.
+ * @param sizeStr2Cols - the size of input string 2.
+ * @param band - the number of diagonals in the band on each side of the corner diagonals.
+ * @return the upper bound, or LLONG_MAX if more gaps may give a better score (so no bound holds).
+ */
+static long long calculateOutOfBandScoreBound(const Aligner* aligner, const int sizeStr1Rows,
+											  const int sizeStr2Cols, const int band)
+{
+	long long minNumOfGaps = abs(sizeStr2Cols - sizeStr1Rows) + 2 * ((long long) band + 1);
+	long long maxNumOfDiagonals = ((long long) sizeStr1Rows + sizeStr2Cols - minNumOfGaps) / 2;
+
+	//every two more gaps replace one diagonal column, so if that doesn't lose score there's no
+	//bound.
+	if(2 * (long long) aligner->gap >= aligner->maxSubstitutionScore)
+	{
+		return LLONG_MAX;
+	}
+
+	return minNumOfGaps * aligner->gap + maxNumOfDiagonals * aligner->maxSubstitutionScore;
+}
+
+/**
+ * This function calculates the best global alignment of the two encoded strings in the workspace
+ * of the aligner, filling only the cells within a band around the diagonals of the scores matrix,
+ * which gives O(band * size) time and memory. If the score can't be proven optimal by the out of
+ * band score bound, the band is doubled (and the cells part of the workspace grows if needed) and
+ * the alignment is calculated again, until it's proven or the band covers the whole matrix - so
+ * the score is always exactly the score of the full matrix.
+ * @param aligner - the aligner.
+ * @param sizeStr1Rows - the size of input string 1.
+ * @param sizeStr2Cols - the size of input string 2.
+ * @param band - the initial number of diagonals in the band on each side of the corner diagonals.
+ * @param alignment - output: the alignment.
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_NO_MEMORY.
+ */
+static AlignStatus calculateBandedAlignment(Aligner* aligner, const int sizeStr1Rows,
+											const int sizeStr2Cols, int band,
+											Alignment *alignment)
+{
+	int cornerDiagonal = sizeStr2Cols - sizeStr1Rows;
+
+	while(TRUE)
+	{
+		int lowDiagonal = ((cornerDiagonal < 0) ? cornerDiagonal : 0) - band;
+		int highDiagonal = ((cornerDiagonal > 0) ? cornerDiagonal : 0) + band;
+		int coversMatrix = (lowDiagonal <= -sizeStr1Rows && highDiagonal >= sizeStr2Cols);
+		size_t bandWidth = (size_t) (highDiagonal - lowDiagonal + 1);
+		size_t numOfRows = (size_t) sizeStr1Rows + 1;
+
+		if(bandWidth > SIZE_MAX / numOfRows ||
+		   reserveWorkspaceForAlignment(aligner, sizeStr1Rows, sizeStr2Cols, numOfRows * bandWidth,
+										0, TRUE) != ALIGN_SUCCESS)
+		{
+			return ALIGN_ERROR_NO_MEMORY;
+		}
+
+		fillBandedScoresMatrix(aligner, aligner->cells, aligner->encodedStrings,
+							   aligner->encodedStrings + sizeStr1Rows + 1, sizeStr1Rows,
+							   sizeStr2Cols, lowDiagonal, highDiagonal);
+
+		int score = aligner->cells[(size_t) sizeStr1Rows * bandWidth +
+								   (size_t) (cornerDiagonal - lowDiagonal)].value;
+
+		if(coversMatrix || score >= calculateOutOfBandScoreBound(aligner, sizeStr1Rows,
+																 sizeStr2Cols, band))
+		{
+			traceBackAlignment(aligner, aligner->cells, (ptrdiff_t) bandWidth - 1, -lowDiagonal,
+							   sizeStr1Rows, sizeStr2Cols, sizeStr1Rows, sizeStr2Cols, FALSE,
+							   TRUE, alignment);
+			return ALIGN_SUCCESS;
+		}
+
+		band = (band == 0) ? 1 : band * 2;
+	}
+}
+
+/**
+ * This function converts a column type of an alignment to its CIGAR operation.
+ * @param type - the column type.
+ * @return 'M' for match or mismatch, 'I' for a gap in string 1 and 'D' for a gap in string 2.
+ */
+static char cigarOperationOfType(const char type)
+{
+	if(type == TYPE_OF_GAP_IN_STR1)
+	{
+		return CIGAR_INSERTION;
+	}
+	if(type == TYPE_OF_GAP_IN_STR2)
+	{
+		return CIGAR_DELETION;
+	}
+	return CIGAR_MATCH;
+}
+
+/**
+ * This function builds the CIGAR string of an alignment in the CIGAR part of the workspace of the
+ * aligner.
+ * @param aligner - the aligner.
+ * @param alignment - the alignment, whose cigar is set.
+ */
+static void buildCigar(const Aligner* aligner, Alignment *alignment)
+{
+	char *cigarEnd = aligner->cigar;
+	int index = 0;
+
+	while(index < alignment->numOfColumns)
+	{
+		char operation = cigarOperationOfType(alignment->columns[index]);
+		int runLength = 0;
+
+		while(index < alignment->numOfColumns &&
+			  cigarOperationOfType(alignment->columns[index]) == operation)
+		{
+			runLength++;
+			index++;
+		}
+
+		cigarEnd += sprintf(cigarEnd, CIGAR_RUN_FORMAT, runLength, operation);
+	}
+
+	*cigarEnd = EMPTY_CHAR;
+	alignment->cigar = aligner->cigar;
+}
+
+/**
+ * This function encodes two strings into the encoded strings part of the workspace of the
+ * aligner, each one null terminated.
+ * @param aligner - the aligner.
+ * @param str1 - input string 1.
+ * @param sizeStr1 - the size of input string 1.
+ * @param str2 - input string 2.
+ * @param sizeStr2 - the size of input string 2.
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_INVALID_RESIDUE.
+ */
+static AlignStatus encodeStrings(Aligner* aligner, const char *str1, const int sizeStr1,
+								 const char *str2, const int sizeStr2)
+{
+	char *encoded = aligner->encodedStrings;
+	int i;
+
+	for(i = 0 ; i < sizeStr1 ; i++)
+	{
+		*encoded = encodeResidue(str1[i]);
+		if(*encoded == NO_RESIDUE_CODE)
+		{
+			return ALIGN_ERROR_INVALID_RESIDUE;
+		}
+		encoded++;
+	}
+	*encoded = EMPTY_CHAR;
+	encoded++;
+
+	for(i = 0 ; i < sizeStr2 ; i++)
+	{
+		*encoded = encodeResidue(str2[i]);
+		if(*encoded == NO_RESIDUE_CODE)
+		{
+			return ALIGN_ERROR_INVALID_RESIDUE;
+		}
+		encoded++;
+	}
+	*encoded = EMPTY_CHAR;
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function calculates the best alignment of two strings of residue letters (upper and lower
+ * case letters are different residues). All the memory it needs comes from the workspace of the
+ * aligner, which only grows, so aligning many pairs allocates only until the workspace fits the
+ * largest pair.
+ * @param aligner - the aligner.
+ * @param str1 - input string 1.
+ * @param sizeStr1 - the size of input string 1.
+ * @param str2 - input string 2.
+ * @param sizeStr2 - the size of input string 2.
+ * @param mode - the alignment mode (global, local or semi-global).
+ * @param band - the initial band of a banded global alignment, or NO_BAND.
+ * @param alignment - output: the alignment, valid until the next alignment of the aligner.
+ * @return ALIGN_SUCCESS, ALIGN_ERROR_NO_MEMORY, ALIGN_ERROR_INVALID_ARGUMENT or
+ *         ALIGN_ERROR_INVALID_RESIDUE.
+ */
+AlignStatus alignSequences(Aligner* aligner, const char *str1, int sizeStr1, const char *str2,
+						   int sizeStr2, AlignmentMode mode, int band, Alignment *alignment)
+{
+	if(aligner == NULL || str1 == NULL || str2 == NULL || alignment == NULL || sizeStr1 < 0 ||
+	   sizeStr2 < 0 || (mode != GLOBAL_ALIGNMENT && mode != LOCAL_ALIGNMENT &&
+						mode != SEMI_GLOBAL_ALIGNMENT) ||
+	   band < NO_BAND || (band != NO_BAND && mode != GLOBAL_ALIGNMENT))
+	{
+		return ALIGN_ERROR_INVALID_ARGUMENT;
+	}
+
+	size_t numOfRows = (size_t) sizeStr1 + 1;
+	size_t numOfCols = (size_t) sizeStr2 + 1;
+	//a banded alignment reserves its cells itself, as its band grows.
+	size_t numOfCells = (band != NO_BAND) ? 0 : numOfRows * numOfCols;
+
+	if((band == NO_BAND && numOfCols > SIZE_MAX / numOfRows) ||
+	   reserveWorkspaceForAlignment(aligner, sizeStr1, sizeStr2, numOfCells, 0,
+									FALSE) != ALIGN_SUCCESS)
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	AlignStatus status = encodeStrings(aligner, str1, sizeStr1, str2, sizeStr2);
+	if(status != ALIGN_SUCCESS)
+	{
+		return status;
+	}
+
+	if(band != NO_BAND)
+	{
+		status = calculateBandedAlignment(aligner, sizeStr1, sizeStr2, band, alignment);
+	}
+	else
+	{
+		calculateBestAlignment(aligner, sizeStr1, sizeStr2, mode, alignment);
+	}
+
+	if(status != ALIGN_SUCCESS)
+	{
+		return status;
+	}
+
+	buildCigar(aligner, alignment);
+	aligner->stats.numOfAlignments++;
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function encodes a letter of a profile row, which is a residue letter or GAP_CHAR.
+ * @param c - the letter.
+ * @param code - output: the residue code, or GAP_CODE.
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_INVALID_RESIDUE.
+ */
+static AlignStatus encodeProfileLetter(const char c, int *code)
+{
+	if(c == GAP_CHAR)
+	{
+		*code = GAP_CODE;
+		return ALIGN_SUCCESS;
+	}
+
+	*code = encodeResidue(c);
+	return (*code == NO_RESIDUE_CODE) ? ALIGN_ERROR_INVALID_RESIDUE : ALIGN_SUCCESS;
+}
+
+/**
+ * This function counts the codes of a column of a profile.
+ * @param profile - the profile.
+ * @param col - the column.
+ * @param counts - output: the count of every code (GAP_CODE for gaps).
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_INVALID_RESIDUE.
+ */
+static AlignStatus countProfileColumn(const Profile *profile, const int col, int *counts)
+{
+	int row;
+	memset(counts, 0, NUM_OF_RESIDUE_CODES * sizeof(int));
+
+	for(row = 0 ; row < profile->numOfRows ; row++)
+	{
+		int code;
+		const char c = profile->rows[(size_t) row * profile->numOfCols + col];
+		if(encodeProfileLetter(c, &code) != ALIGN_SUCCESS)
+		{
+			return ALIGN_ERROR_INVALID_RESIDUE;
+		}
+		counts[code]++;
+	}
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function returns the maximal number of different codes in a column of a profile.
+ * @param profile - the profile.
+ * @return the number of codes.
+ */
+static size_t numOfCodesPerCol(const Profile *profile)
+{
+	return (profile->numOfRows < NUM_OF_RESIDUE_CODES) ? (size_t) profile->numOfRows :
+		   NUM_OF_RESIDUE_CODES;
+}
+
+/**
+ * This function calculates the size of the extra part of the workspace which the scores of the
+ * columns of two profiles need.
+ * @param profile1 - profile 1.
+ * @param profile2 - profile 2.
+ * @return the size in bytes.
+ */
+static size_t calculateProfileScoresSize(const Profile *profile1, const Profile *profile2)
+{
+	size_t size1 = (size_t) profile1->numOfCols;
+	size_t size2 = (size_t) profile2->numOfCols;
+
+	return sizeof(int) * (size1 * NUM_OF_RESIDUE_CODES + size2 + size1 + (size2 + 1) +
+						  2 * size2 * numOfCodesPerCol(profile2));
+}
+
+/**
+ * This function calculates the data the columns of two profiles are scored by (sum of pairs: the
+ * score of two columns is the average score of all the pairs of a row of profile 1 and a row of
+ * profile 2, scaled by PROFILE_SCORE_SCALE), in the extra part of the workspace of the aligner.
+ * @param aligner - the aligner.
+ * @param profile1 - profile 1.
+ * @param profile2 - profile 2.
+ * @param scores - output: the scores data.
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_INVALID_RESIDUE.
+ */
+static AlignStatus calculateProfileScores(const Aligner* aligner, const Profile *profile1,
+										  const Profile *profile2, ProfileScores *scores)
+{
+	const int size1 = profile1->numOfCols;
+	const int size2 = profile2->numOfCols;
+	int counts[NUM_OF_RESIDUE_CODES];
+	int i;
+	int a;
+	int b;
+
+	scores->weights1 = (int*) aligner->extra;
+	scores->gapCosts1 = scores->weights1 + (size_t) size1 * NUM_OF_RESIDUE_CODES;
+	scores->gapCosts2 = scores->gapCosts1 + size2;
+	scores->offsets2 = scores->gapCosts2 + size1;
+	scores->codes2 = scores->offsets2 + size2 + 1;
+	scores->counts2 = scores->codes2 + (size_t) size2 * numOfCodesPerCol(profile2);
+	scores->numOfPairs = (long long) profile1->numOfRows * profile2->numOfRows;
+
+	for(i = 0 ; i < size1 ; i++)
+	{
+		if(countProfileColumn(profile1, i, counts) != ALIGN_SUCCESS)
+		{
+			return ALIGN_ERROR_INVALID_RESIDUE;
+		}
+
+		int *weights = scores->weights1 + (size_t) i * NUM_OF_RESIDUE_CODES;
+		for(b = 0 ; b < NUM_OF_RESIDUE_CODES ; b++)
+		{
+			weights[b] = (b == GAP_CODE) ? 0 : counts[GAP_CODE] * aligner->gap;
+		}
+		for(a = 0 ; a < NUM_OF_RESIDUE_CODES ; a++)
+		{
+			if(a == GAP_CODE || counts[a] == 0)
+			{
+				continue;
+			}
+			weights[GAP_CODE] += counts[a] * aligner->gap;
+			for(b = 0 ; b < NUM_OF_RESIDUE_CODES ; b++)
+			{
+				if(b != GAP_CODE)
+				{
+					weights[b] += counts[a] * aligner->substitutionTable[a][b];
+				}
+			}
+		}
+
+		int numOfResidues = profile1->numOfRows - counts[GAP_CODE];
+		scores->gapCosts2[i] = (int) ((long long) aligner->gap * numOfResidues *
+									  PROFILE_SCORE_SCALE / profile1->numOfRows);
+	}
+
+	int numOfCodes = 0;
+	for(i = 0 ; i < size2 ; i++)
+	{
+		if(countProfileColumn(profile2, i, counts) != ALIGN_SUCCESS)
+		{
+			return ALIGN_ERROR_INVALID_RESIDUE;
+		}
+
+		scores->offsets2[i] = numOfCodes;
+		for(b = 0 ; b < NUM_OF_RESIDUE_CODES ; b++)
+		{
+			if(counts[b] > 0)
+			{
+				scores->codes2[numOfCodes] = b;
+				scores->counts2[numOfCodes] = counts[b];
+				numOfCodes++;
+			}
+		}
+
+		int numOfResidues = profile2->numOfRows - counts[GAP_CODE];
+		scores->gapCosts1[i] = (int) ((long long) aligner->gap * numOfResidues *
+									  PROFILE_SCORE_SCALE / profile2->numOfRows);
+	}
+	scores->offsets2[size2] = numOfCodes;
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function fills the scores matrix of a global alignment of two profiles, laid out row after
+ * row in the cells part of the workspace of the aligner (ties are broken like in the alignment of
+ * two strings).
+ * @param aligner - the aligner.
+ * @param scores - the data the columns are scored by.
+ * @param sizeProfile1Rows - the number of columns of profile 1.
+ * @param sizeProfile2Cols - the number of columns of profile 2.
+ */
+static void fillProfileScoresMatrix(const Aligner* aligner, const ProfileScores *scores,
+									const int sizeProfile1Rows, const int sizeProfile2Cols)
+{
+	CellOfScoresMatrix *scoresMatrix = aligner->cells;
+	const size_t numOfCols = (size_t) sizeProfile2Cols + 1;
+	int i;
+	int j;
+
+	scoresMatrix[0].value = 0;
+	scoresMatrix[0].typeOfPrevCell = TYPE_OF_FIRST_CELL;
+	for(j = 0 ; j < sizeProfile2Cols ; j++)
+	{
+		scoresMatrix[j + 1].value = scoresMatrix[j].value + scores->gapCosts1[j];
+		scoresMatrix[j + 1].typeOfPrevCell = TYPE_OF_GAP_IN_STR1;
+	}
+
+	for(i = 0 ; i < sizeProfile1Rows ; i++)
+	{
+		const int *weights = scores->weights1 + (size_t) i * NUM_OF_RESIDUE_CODES;
+		const CellOfScoresMatrix *prevRow = scoresMatrix + (size_t) i * numOfCols;
+		CellOfScoresMatrix *row = scoresMatrix + (size_t) (i + 1) * numOfCols;
+
+		row[0].value = prevRow[0].value + scores->gapCosts2[i];
+		row[0].typeOfPrevCell = TYPE_OF_GAP_IN_STR2;
+
+		for(j = 0 ; j < sizeProfile2Cols ; j++)
+		{
+			long long sumOfPairs = 0;
+			int k;
+			for(k = scores->offsets2[j] ; k < scores->offsets2[j + 1] ; k++)
+			{
+				sumOfPairs += (long long) scores->counts2[k] * weights[scores->codes2[k]];
+			}
+
+			CellOfScoresMatrix *cell = &row[j + 1];
+			int diagonalResult = prevRow[j].value +
+								 (int) (sumOfPairs * PROFILE_SCORE_SCALE / scores->numOfPairs);
+			int gapResult1 = prevRow[j + 1].value + scores->gapCosts2[i];
+			int gapResult2 = row[j].value + scores->gapCosts1[j];
+			int result = maxOfThreeCalculator(diagonalResult, gapResult1, gapResult2);
+			if(result == diagonalResult)
+			{
+				cell->typeOfPrevCell = TYPE_OF_DIAGONAL;
+			}
+			else if(result == gapResult1)
+			{
+				cell->typeOfPrevCell = TYPE_OF_GAP_IN_STR2;
+			}
+			else
+			{
+				cell->typeOfPrevCell = TYPE_OF_GAP_IN_STR1;
+			}
+			cell->value = result;
+		}
+	}
+}
+
+/**
+ * This function calculates the best global alignment of two profiles (aligned groups of strings,
+ * for progressive multiple alignment). Every column of the alignment is a column of both
+ * profiles (TYPE_OF_MATCH), a column of profile 2 against gaps in profile 1 (TYPE_OF_GAP_IN_STR1)
+ * or a column of profile 1 against gaps in profile 2 (TYPE_OF_GAP_IN_STR2). The score is the sum
+ * of pairs score of the columns, averaged over the pairs of rows and scaled by
+ * PROFILE_SCORE_SCALE.
+ * @param aligner - the aligner.
+ * @param profile1 - profile 1.
+ * @param profile2 - profile 2.
+ * @param alignment - output: the alignment, valid until the next alignment of the aligner.
+ * @return ALIGN_SUCCESS, ALIGN_ERROR_NO_MEMORY, ALIGN_ERROR_INVALID_ARGUMENT or
+ *         ALIGN_ERROR_INVALID_RESIDUE.
+ */
+AlignStatus alignProfiles(Aligner* aligner, const Profile *profile1, const Profile *profile2,
+						  Alignment *alignment)
+{
+	if(aligner == NULL || profile1 == NULL || profile2 == NULL || alignment == NULL ||
+	   profile1->rows == NULL || profile2->rows == NULL || profile1->numOfRows < 1 ||
+	   profile2->numOfRows < 1 || profile1->numOfCols < 0 || profile2->numOfCols < 0)
+	{
+		return ALIGN_ERROR_INVALID_ARGUMENT;
+	}
+
+	size_t numOfRows = (size_t) profile1->numOfCols + 1;
+	size_t numOfCols = (size_t) profile2->numOfCols + 1;
+
+	if(numOfCols > SIZE_MAX / numOfRows ||
+	   reserveWorkspaceForAlignment(aligner, profile1->numOfCols, profile2->numOfCols,
+									numOfRows * numOfCols,
+									calculateProfileScoresSize(profile1, profile2),
+									FALSE) != ALIGN_SUCCESS)
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	ProfileScores scores;
+	AlignStatus status = calculateProfileScores(aligner, profile1, profile2, &scores);
+	if(status != ALIGN_SUCCESS)
+	{
+		return status;
+	}
+
+	fillProfileScoresMatrix(aligner, &scores, profile1->numOfCols, profile2->numOfCols);
+	traceBackAlignment(aligner, aligner->cells, (ptrdiff_t) numOfCols, 0, profile1->numOfCols,
+					   profile2->numOfCols, profile1->numOfCols, profile2->numOfCols, FALSE,
+					   FALSE, alignment);
+
+	buildCigar(aligner, alignment);
+	aligner->stats.numOfAlignments++;
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function returns a message which describes a status.
+ * @param status - the status.
+ * @return the message.
+ */
+const char* alignStatusMessage(AlignStatus status)
+{
+	switch(status)
+	{
+		case ALIGN_SUCCESS:
+			return SUCCESS_MESSAGE;
+		case ALIGN_ERROR_NO_MEMORY:
+			return NO_MEMORY_MESSAGE;
+		case ALIGN_ERROR_INVALID_ARGUMENT:
+			return INVALID_ARGUMENT_MESSAGE;
+		case ALIGN_ERROR_INVALID_RESIDUE:
+			return INVALID_RESIDUE_MESSAGE;
+		case ALIGN_ERROR_FILE_NOT_FOUND:
+			return FILE_NOT_FOUND_MESSAGE;
+		case ALIGN_ERROR_INVALID_MATRIX_FILE:
+			return INVALID_MATRIX_FILE_MESSAGE;
+		default:
+			return UNKNOWN_STATUS_MESSAGE;
+	}
+}
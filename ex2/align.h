@@ -0,0 +1,110 @@
+#ifndef ALIGN_H
+#define ALIGN_H
+
+#include <stddef.h>
+
+/**
+ * The band value which means the alignment isn't banded (the whole scores matrix is filled).
+ */
+#define NO_BAND -1
+
+/**
+ * The letter of a gap in the rows of a profile.
+ */
+#define GAP_CHAR '-'
+
+/**
+ * The types of the columns of a restored alignment: a match, a mismatch, a residue of string 2
+ * against a gap in string 1, and a residue of string 1 against a gap in string 2.
+ */
+#define TYPE_OF_MATCH 'm'
+#define TYPE_OF_MISMATCH 's'
+#define TYPE_OF_GAP_IN_STR1 '1'
+#define TYPE_OF_GAP_IN_STR2 '2'
+
+/**
+ * This enum represents the alignment modes: global (Needleman-Wunsch), local (Smith-Waterman) and
+ * semi-global (gaps at the ends of both strings are free, for overlap alignments).
+ */
+typedef enum AlignmentMode
+{
+	GLOBAL_ALIGNMENT,
+	LOCAL_ALIGNMENT,
+	SEMI_GLOBAL_ALIGNMENT
+} AlignmentMode;
+
+/**
+ * This enum represents the status every library function returns, instead of exiting.
+ */
+typedef enum AlignStatus
+{
+	ALIGN_SUCCESS,
+	ALIGN_ERROR_NO_MEMORY,
+	ALIGN_ERROR_INVALID_ARGUMENT,
+	ALIGN_ERROR_INVALID_RESIDUE,
+	ALIGN_ERROR_FILE_NOT_FOUND,
+	ALIGN_ERROR_INVALID_MATRIX_FILE
+} AlignStatus;
+
+/**
+ * This struct represents the best alignment of two strings. Its columns and CIGAR string live in
+ * the workspace of the aligner which calculated it, until its next alignment.
+ */
+typedef struct Alignment
+{
+	int score;
+	int startInStr1;   // the location in each string where the alignment starts.
+	int startInStr2;
+	const char *columns;   // the type of every column, in order (not null terminated).
+	int numOfColumns;
+	const char *cigar;   // runs of 'M' (match or mismatch), 'I' (TYPE_OF_GAP_IN_STR1) and
+						 // 'D' (TYPE_OF_GAP_IN_STR2), null terminated.
+} Alignment;
+
+/**
+ * This struct represents a profile: a group of aligned strings, as rows of residue letters and
+ * GAP_CHAR of the same size, stored one after the other (not null terminated).
+ */
+typedef struct Profile
+{
+	const char *rows;
+	int numOfRows;
+	int numOfCols;
+} Profile;
+
+/**
+ * This struct represents the statistics of an aligner, which show that its workspace stops
+ * growing once it fits the largest pair (so there are no allocations in the steady state).
+ */
+typedef struct AlignerStats
+{
+	size_t numOfAlignments;
+	size_t numOfAllocations;   // of the workspace.
+	size_t workspaceSize;   // in bytes.
+} AlignerStats;
+
+/**
+ * An aligner holds the scores and the reusable workspace of alignments. It's not shared between
+ * threads: every thread uses its own aligner, and then all the functions are reentrant.
+ */
+typedef struct Aligner Aligner;
+
+Aligner* alignerAlloc(int match, int mismatch, int gap);
+
+void freeAligner(Aligner** aligner);
+
+AlignerStats alignerStats(const Aligner* aligner);
+
+Aligner* alignerClone(const Aligner* aligner);
+
+AlignStatus alignerLoadMatrix(Aligner* aligner, const char *filePath);
+
+AlignStatus alignSequences(Aligner* aligner, const char *str1, int sizeStr1, const char *str2,
+						   int sizeStr2, AlignmentMode mode, int band, Alignment *alignment);
+
+AlignStatus alignProfiles(Aligner* aligner, const Profile *profile1, const Profile *profile2,
+						  Alignment *alignment);
+
+const char* alignStatusMessage(AlignStatus status);
+
+#endif
@@ -0,0 +1,269 @@
+//================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
+#include "editdistance.h"
+
+#include <string.h>
+#include <stdlib.h>
+//================================ Constants ====================================================
+#define NUM_OF_NUCLEOTIDES 4
+#define NOT_A_NUCLEOTIDE NUM_OF_NUCLEOTIDES
+#define BITS_PER_NUCLEOTIDE 2
+#define NUCLEOTIDE_MASK 3
+#define BITS_PER_WORD 64
+#define NUCLEOTIDES_PER_WORD (BITS_PER_WORD / BITS_PER_NUCLEOTIDE)
+
+//================================ Code Segment =================================================
+
+/**
+ * This struct represents an edit distance query: the size of its string, and one block with the
+ * match bit-vectors of the string (NUM_OF_NUCLEOTIDES * maxNumOfBlocks words) and the vertical
+ * deltas bit-vectors of the blocks (2 * maxNumOfBlocks words).
+ */
+struct EditDistanceQuery
+{
+	int sizeOfQuery;
+	int numOfBlocks;
+	int maxNumOfBlocks;
+	uint64_t *peq;
+	uint64_t *pv;
+	uint64_t *mv;
+};
+
+/**
+ * This function returns the 2 bits nucleotide value of a residue letter ('A' = 0, 'C' = 1,
+ * 'G' = 2, 'T' = 3, in both cases).
+ * @param c - the residue letter.
+ * @return the nucleotide value, or NOT_A_NUCLEOTIDE.
+ */
+static int nucleotideBits(const char c)
+{
+	switch(c)
+	{
+		case 'A': case 'a':
+			return 0;
+		case 'C': case 'c':
+			return 1;
+		case 'G': case 'g':
+			return 2;
+		case 'T': case 't':
+			return 3;
+		default:
+			return NOT_A_NUCLEOTIDE;
+	}
+}
+
+/**
+ * This function returns the nucleotide value at a position of a packed DNA string.
+ * @param packedStr - the packed string.
+ * @param pos - the position.
+ * @return the nucleotide value.
+ */
+static int packedNucleotideAt(const uint64_t *packedStr, const int pos)
+{
+	return (int) ((packedStr[pos / NUCLEOTIDES_PER_WORD] >>
+				   (BITS_PER_NUCLEOTIDE * (pos % NUCLEOTIDES_PER_WORD))) & NUCLEOTIDE_MASK);
+}
+
+/**
+ * This function returns the number of 64 bit words of a DNA string packed to 2 bits per
+ * nucleotide, 32 nucleotides in every word.
+ * @param sizeStr - the size of the string.
+ * @return the number of words.
+ */
+size_t packedDnaSize(int sizeStr)
+{
+	return ((size_t) sizeStr + NUCLEOTIDES_PER_WORD - 1) / NUCLEOTIDES_PER_WORD;
+}
+
+/**
+ * This function packs a DNA string to 2 bits per nucleotide.
+ * @param str - the string.
+ * @param sizeStr - the size of the string.
+ * @param packedStr - output: the packed string, packedDnaSize(sizeStr) words.
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_INVALID_RESIDUE if the string has a residue which isn't a
+ *         nucleotide.
+ */
+AlignStatus packDnaString(const char *str, int sizeStr, uint64_t *packedStr)
+{
+	int pos;
+
+	memset(packedStr, 0, packedDnaSize(sizeStr) * sizeof(uint64_t));
+
+	for(pos = 0 ; pos < sizeStr ; pos++)
+	{
+		int bits = nucleotideBits(str[pos]);
+		if(bits == NOT_A_NUCLEOTIDE)
+		{
+			return ALIGN_ERROR_INVALID_RESIDUE;
+		}
+		int shift = BITS_PER_NUCLEOTIDE * (pos % NUCLEOTIDES_PER_WORD);
+		packedStr[pos / NUCLEOTIDES_PER_WORD] |= (uint64_t) bits << shift;
+	}
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function allocates a new edit distance query, for strings of at most maxSizeOfQuery
+ * nucleotides.
+ * @param maxSizeOfQuery - the maximal size of the strings of the query.
+ * @return the new query, or NULL if there's not enough memory.
+ */
+EditDistanceQuery* editDistanceQueryAlloc(int maxSizeOfQuery)
+{
+	if(maxSizeOfQuery < 0)
+	{
+		return NULL;
+	}
+
+	int maxNumOfBlocks = (maxSizeOfQuery + BITS_PER_WORD - 1) / BITS_PER_WORD + 1;
+	EditDistanceQuery* query = (EditDistanceQuery*) calloc(1, sizeof(EditDistanceQuery));
+	uint64_t *words = (uint64_t*) calloc((size_t) (NUM_OF_NUCLEOTIDES + 2) * maxNumOfBlocks,
+										 sizeof(uint64_t));
+	if(query == NULL || words == NULL)
+	{
+		free(query);
+		free(words);
+		return NULL;
+	}
+
+	query->maxNumOfBlocks = maxNumOfBlocks;
+	query->peq = words;
+	query->pv = words + NUM_OF_NUCLEOTIDES * maxNumOfBlocks;
+	query->mv = query->pv + maxNumOfBlocks;
+
+	return query;
+}
+
+/**
+ * This function frees an edit distance query.
+ * @param query - a pointer to the query, which is set to NULL.
+ */
+void freeEditDistanceQuery(EditDistanceQuery** query)
+{
+	if(*query == NULL)
+	{
+		return;
+	}
+
+	free((*query)->peq);
+	free(*query);
+	*query = NULL;
+}
+
+/**
+ * This function returns the size of the bit-vectors of an edit distance query.
+ * @param query - the query.
+ * @return the size, in bytes.
+ */
+size_t editDistanceQuerySize(const EditDistanceQuery* query)
+{
+	return (size_t) (NUM_OF_NUCLEOTIDES + 2) * query->maxNumOfBlocks * sizeof(uint64_t);
+}
+
+/**
+ * This function sets the string of an edit distance query, and builds its match bit-vectors: bit
+ * r of peq[nucleotide * numOfBlocks + block] is set if row (block * 64 + r) holds this nucleotide.
+ * @param query - the query.
+ * @param packedStr - the packed string.
+ * @param sizeStr - the size of the string.
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_INVALID_ARGUMENT if the string is longer than the query
+ *         was allocated for.
+ */
+AlignStatus setEditDistanceQuery(EditDistanceQuery* query, const uint64_t *packedStr, int sizeStr)
+{
+	int numOfBlocks = (sizeStr + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	int pos;
+
+	if(sizeStr < 0 || numOfBlocks > query->maxNumOfBlocks)
+	{
+		return ALIGN_ERROR_INVALID_ARGUMENT;
+	}
+
+	query->sizeOfQuery = sizeStr;
+	query->numOfBlocks = numOfBlocks;
+	memset(query->peq, 0, (size_t) NUM_OF_NUCLEOTIDES * numOfBlocks * sizeof(uint64_t));
+
+	for(pos = 0 ; pos < sizeStr ; pos++)
+	{
+		int bits = packedNucleotideAt(packedStr, pos);
+		int block = pos / BITS_PER_WORD;
+		query->peq[bits * numOfBlocks + block] |= (uint64_t) 1 << (pos % BITS_PER_WORD);
+	}
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function advances one 64 rows block of Myers' bit-vector algorithm by one column of the
+ * edit distance matrix, and returns the horizontal delta it passes to the block below it.
+ * @param pv - the positive vertical deltas bit-vector of the block (updated).
+ * @param mv - the negative vertical deltas bit-vector of the block (updated).
+ * @param eq - the bit-vector of the rows of the block which match the nucleotide of the column.
+ * @param hin - the horizontal delta (-1, 0 or +1) the block gets from the block above it.
+ * @param outBit - the row (in the block) whose horizontal delta to return.
+ * @return the horizontal delta (-1, 0 or +1) of row outBit.
+ */
+static int advanceMyersBlock(uint64_t *pv, uint64_t *mv, uint64_t eq, const int hin,
+							 const int outBit)
+{
+	uint64_t hinIsNegative = (hin < 0);
+	uint64_t xv = eq | *mv;
+	eq |= hinIsNegative;
+	uint64_t xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+	uint64_t ph = *mv | ~(xh | *pv);
+	uint64_t mh = *pv & xh;
+	int hout = (int) ((ph >> outBit) & 1) - (int) ((mh >> outBit) & 1);
+
+	ph = (ph << 1) | (uint64_t) (hin > 0);
+	mh = (mh << 1) | hinIsNegative;
+	*pv = mh | ~(xv | ph);
+	*mv = ph & xv;
+
+	return hout;
+}
+
+/**
+ * This function calculates the (unit cost) edit distance of the string of a query and a text
+ * string with Myers' bit-vector algorithm: every column of the edit distance matrix is kept as
+ * bit-vectors of its vertical deltas, so 64 cells are calculated at once, in blocks of 64 rows.
+ * @param query - the query.
+ * @param packedText - the packed text string.
+ * @param sizeOfText - the size of the text string.
+ * @return the edit distance of the two strings.
+ */
+int calculateEditDistance(EditDistanceQuery* query, const uint64_t *packedText, int sizeOfText)
+{
+	int numOfBlocks = query->numOfBlocks;
+	int lastBit = (query->sizeOfQuery - 1) % BITS_PER_WORD;
+	int distance = query->sizeOfQuery;
+	int pos;
+	int block;
+
+	if(query->sizeOfQuery == 0)
+	{
+		return sizeOfText;
+	}
+
+	for(block = 0 ; block < numOfBlocks ; block++)
+	{
+		query->pv[block] = ~(uint64_t) 0;
+		query->mv[block] = 0;
+	}
+
+	for(pos = 0 ; pos < sizeOfText ; pos++)
+	{
+		const uint64_t *eq = query->peq + packedNucleotideAt(packedText, pos) * numOfBlocks;
+		int hout = 1;
+
+		for(block = 0 ; block < numOfBlocks - 1 ; block++)
+		{
+			hout = advanceMyersBlock(&query->pv[block], &query->mv[block], eq[block], hout,
+									 BITS_PER_WORD - 1);
+		}
+		distance += advanceMyersBlock(&query->pv[block], &query->mv[block], eq[block], hout,
+									  lastBit);
+	}
+
+	return distance;
+}
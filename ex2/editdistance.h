@@ -0,0 +1,30 @@
+#ifndef EDITDISTANCE_H
+#define EDITDISTANCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "align.h"
+
+/**
+ * An edit distance query holds the match bit-vectors of a packed DNA string (2 bits per
+ * nucleotide) and the workspace of Myers' bit-vector algorithm, so the (unit cost) edit distances
+ * of the string to many others are calculated without building them again. It's not shared
+ * between threads: every thread uses its own query.
+ */
+typedef struct EditDistanceQuery EditDistanceQuery;
+
+size_t packedDnaSize(int sizeStr);
+
+AlignStatus packDnaString(const char *str, int sizeStr, uint64_t *packedStr);
+
+EditDistanceQuery* editDistanceQueryAlloc(int maxSizeOfQuery);
+
+void freeEditDistanceQuery(EditDistanceQuery** query);
+
+size_t editDistanceQuerySize(const EditDistanceQuery* query);
+
+AlignStatus setEditDistanceQuery(EditDistanceQuery* query, const uint64_t *packedStr, int sizeStr);
+
+int calculateEditDistance(EditDistanceQuery* query, const uint64_t *packedText, int sizeOfText);
+
+#endif
@@ -0,0 +1,547 @@
+//================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
+#include "msa.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+//================================ Constants ====================================================
+#define TRUE 1
+#define FALSE 0
+#define NO_NODE -1
+#define EMPTY_CHAR '\0'
+#define HALF 2.0
+
+//================================ Code Segment =================================================
+
+/**
+ * This struct represents a node of the guide tree. Nodes 0 to (numOfStrs - 1) are the leaves (the
+ * strings), and every other node is the merge of its two children, whose profiles are aligned into
+ * its profile once both of them are ready.
+ */
+typedef struct TreeNode
+{
+	int left;
+	int right;
+	int parent;
+	int str;   // the string of a leaf.
+	int numOfPendingChildren;   // the children which aren't merged yet.
+	Profile profile;
+	char *rows;   // the rows of the profile, if the node owns them (not a leaf).
+	int *members;   // the string of every row of the profile.
+} TreeNode;
+
+/**
+ * This struct represents the queue of the nodes which are ready to be merged (both of their
+ * children are ready), which the merging threads share. Nodes of independent subtrees are merged
+ * at the same time.
+ */
+typedef struct MergeQueue
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t nodeIsReady;
+	const Aligner* aligner;   // every thread aligns with a clone of it.
+	TreeNode *nodes;
+	int *readyNodes;
+	int head;
+	int tail;
+	int numOfRemainingNodes;   // the nodes which aren't merged yet.
+	AlignStatus status;
+} MergeQueue;
+
+/**
+ * This function finds the nearest active cluster to a cluster (the first one of the nearest).
+ * @param distances - the distances between the clusters.
+ * @param isActive - TRUE for every cluster which wasn't merged into another one.
+ * @param numOfClusters - the number of clusters.
+ * @param cluster - the cluster.
+ * @param nearest - output: the nearest cluster, or NO_NODE if there's no other active cluster.
+ * @param nearestDistance - output: the distance to the nearest cluster.
+ */
+static void findNearestCluster(const double *distances, const char *isActive,
+							   const int numOfClusters, const int cluster, int *nearest,
+							   double *nearestDistance)
+{
+	const double *row = distances + (size_t) cluster * numOfClusters;
+	int k;
+
+	*nearest = NO_NODE;
+	for(k = 0 ; k < numOfClusters ; k++)
+	{
+		if(k != cluster && isActive[k] && (*nearest == NO_NODE || row[k] < *nearestDistance))
+		{
+			*nearest = k;
+			*nearestDistance = row[k];
+		}
+	}
+}
+
+/**
+ * This function builds the guide tree of the strings by UPGMA on the distances of their pairwise
+ * scores: the distance of strings i and j is (score(i, i) + score(j, j)) / 2 - score(i, j), and
+ * the two nearest clusters are merged again and again, where the distance to a merged cluster is
+ * the average of the distances to both of them (weighted by their sizes). The nearest cluster of
+ * every cluster is cached, so a merge usually takes linear time.
+ * @param scores - the pairwise scores, numOfStrs * numOfStrs.
+ * @param numOfStrs - the number of strings.
+ * @param nodes - output: the (2 * numOfStrs - 1) nodes of the tree, whose root is the last one.
+ * @return ALIGN_SUCCESS, or ALIGN_ERROR_NO_MEMORY.
+ */
+static AlignStatus buildGuideTree(const int *scores, const int numOfStrs, TreeNode *nodes)
+{
+	size_t n = (size_t) numOfStrs;
+	if(n > SIZE_MAX / sizeof(double) / n)
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	double *distances = (double*) malloc(n * n * sizeof(double));
+	double *nearestDistances = (double*) malloc(n * sizeof(double));
+	int *nearest = (int*) malloc(n * sizeof(int));
+	int *clusterNodes = (int*) malloc(n * sizeof(int));
+	int *clusterSizes = (int*) malloc(n * sizeof(int));
+	char *isActive = (char*) malloc(n);
+	AlignStatus status = ALIGN_ERROR_NO_MEMORY;
+	int i;
+	int k;
+
+	if(distances != NULL && nearestDistances != NULL && nearest != NULL && clusterNodes != NULL &&
+	   clusterSizes != NULL && isActive != NULL)
+	{
+		for(i = 0 ; i < numOfStrs ; i++)
+		{
+			for(k = 0 ; k < numOfStrs ; k++)
+			{
+				distances[i * n + k] = (scores[i * n + i] + scores[k * n + k]) / HALF -
+									   scores[i * n + k];
+			}
+			clusterNodes[i] = i;
+			clusterSizes[i] = 1;
+			isActive[i] = TRUE;
+		}
+		for(i = 0 ; i < numOfStrs ; i++)
+		{
+			findNearestCluster(distances, isActive, numOfStrs, i, &nearest[i],
+							   &nearestDistances[i]);
+		}
+
+		int newNode;
+		for(newNode = numOfStrs ; newNode < 2 * numOfStrs - 1 ; newNode++)
+		{
+			//the nearest pair of clusters is merged into the first one of them.
+			int first = NO_NODE;
+			for(i = 0 ; i < numOfStrs ; i++)
+			{
+				if(isActive[i] && (first == NO_NODE || nearestDistances[i] <
+													   nearestDistances[first]))
+				{
+					first = i;
+				}
+			}
+			int second = nearest[first];
+
+			nodes[newNode].left = clusterNodes[first];
+			nodes[newNode].right = clusterNodes[second];
+			nodes[clusterNodes[first]].parent = newNode;
+			nodes[clusterNodes[second]].parent = newNode;
+			nodes[newNode].numOfPendingChildren = (clusterNodes[first] >= numOfStrs) +
+												  (clusterNodes[second] >= numOfStrs);
+
+			for(k = 0 ; k < numOfStrs ; k++)
+			{
+				if(isActive[k] && k != first && k != second)
+				{
+					double distance = (clusterSizes[first] * distances[first * n + k] +
+									   clusterSizes[second] * distances[second * n + k]) /
+									  (clusterSizes[first] + clusterSizes[second]);
+					distances[first * n + k] = distance;
+					distances[k * n + first] = distance;
+				}
+			}
+			clusterSizes[first] += clusterSizes[second];
+			clusterNodes[first] = newNode;
+			isActive[second] = FALSE;
+
+			for(k = 0 ; k < numOfStrs ; k++)
+			{
+				if(!isActive[k] || k == first)
+				{
+					continue;
+				}
+				if(nearest[k] == first || nearest[k] == second)
+				{
+					findNearestCluster(distances, isActive, numOfStrs, k, &nearest[k],
+									   &nearestDistances[k]);
+				}
+				else if(distances[k * n + first] < nearestDistances[k])
+				{
+					nearest[k] = first;
+					nearestDistances[k] = distances[k * n + first];
+				}
+			}
+			findNearestCluster(distances, isActive, numOfStrs, first, &nearest[first],
+							   &nearestDistances[first]);
+		}
+
+		status = ALIGN_SUCCESS;
+	}
+
+	free(distances);
+	free(nearestDistances);
+	free(nearest);
+	free(clusterNodes);
+	free(clusterSizes);
+	free(isActive);
+
+	return status;
+}
+
+/**
+ * This function copies a row of a profile into a row of the alignment of two profiles, with a gap
+ * in every column of the given gap type.
+ * @param alignment - the alignment of the two profiles.
+ * @param row - the row of the profile.
+ * @param gapType - the type of the columns where the profile has gaps.
+ * @param alignedRow - output: the row in the alignment.
+ */
+static void copyRowWithGaps(const Alignment *alignment, const char *row, const char gapType,
+							char *alignedRow)
+{
+	int k;
+	for(k = 0 ; k < alignment->numOfColumns ; k++)
+	{
+		if(alignment->columns[k] == gapType)
+		{
+			alignedRow[k] = GAP_CHAR;
+		}
+		else
+		{
+			alignedRow[k] = *row;
+			row++;
+		}
+	}
+}
+
+/**
+ * This function frees the profile of a node, if the node owns it.
+ * @param node - the node.
+ */
+static void freeProfileOfNode(TreeNode *node)
+{
+	if(node->rows != NULL)
+	{
+		free(node->rows);
+		free(node->members);
+		node->rows = NULL;
+		node->members = NULL;
+	}
+}
+
+/**
+ * This function merges the two children of a node: it aligns their profiles into the profile of
+ * the node (the rows of the left child and then the rows of the right child), and frees theirs.
+ * @param aligner - the aligner of the thread.
+ * @param nodes - the nodes of the guide tree.
+ * @param node - the node.
+ * @return ALIGN_SUCCESS, or the status of the failure.
+ */
+static AlignStatus mergeChildren(Aligner* aligner, TreeNode *nodes, const int node)
+{
+	TreeNode *left = &nodes[nodes[node].left];
+	TreeNode *right = &nodes[nodes[node].right];
+	Alignment alignment;
+
+	AlignStatus status = alignProfiles(aligner, &left->profile, &right->profile, &alignment);
+	if(status != ALIGN_SUCCESS)
+	{
+		return status;
+	}
+
+	int numOfRows = left->profile.numOfRows + right->profile.numOfRows;
+	size_t numOfCols = (size_t) alignment.numOfColumns;
+	if(numOfCols > 0 && (size_t) numOfRows > SIZE_MAX / numOfCols)
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	char *rows = (char*) malloc((size_t) numOfRows * numOfCols + 1);
+	int *members = (int*) malloc((size_t) numOfRows * sizeof(int));
+	if(rows == NULL || members == NULL)
+	{
+		free(rows);
+		free(members);
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	int row;
+	for(row = 0 ; row < numOfRows ; row++)
+	{
+		if(row < left->profile.numOfRows)
+		{
+			copyRowWithGaps(&alignment, left->profile.rows + (size_t) row *
+										left->profile.numOfCols,
+							TYPE_OF_GAP_IN_STR1, rows + (size_t) row * numOfCols);
+			members[row] = left->members[row];
+		}
+		else
+		{
+			int rightRow = row - left->profile.numOfRows;
+			copyRowWithGaps(&alignment, right->profile.rows + (size_t) rightRow *
+										right->profile.numOfCols,
+							TYPE_OF_GAP_IN_STR2, rows + (size_t) row * numOfCols);
+			members[row] = right->members[rightRow];
+		}
+	}
+
+	nodes[node].rows = rows;
+	nodes[node].members = members;
+	nodes[node].profile.rows = rows;
+	nodes[node].profile.numOfRows = numOfRows;
+	nodes[node].profile.numOfCols = alignment.numOfColumns;
+
+	freeProfileOfNode(left);
+	freeProfileOfNode(right);
+
+	return ALIGN_SUCCESS;
+}
+
+/**
+ * This function is run by every merging thread: it merges ready nodes until all the nodes are
+ * merged, or until a merge fails. A node becomes ready when its last child is merged.
+ * @param arg - the merge queue.
+ * @return NULL.
+ */
+static void* mergeReadyNodes(void *arg)
+{
+	MergeQueue *queue = (MergeQueue*) arg;
+	Aligner* aligner = alignerClone(queue->aligner);
+
+	pthread_mutex_lock(&queue->mutex);
+	if(aligner == NULL)
+	{
+		queue->status = ALIGN_ERROR_NO_MEMORY;
+		pthread_cond_broadcast(&queue->nodeIsReady);
+	}
+
+	while(queue->status == ALIGN_SUCCESS && queue->numOfRemainingNodes > 0)
+	{
+		if(queue->head == queue->tail)
+		{
+			pthread_cond_wait(&queue->nodeIsReady, &queue->mutex);
+			continue;
+		}
+
+		int node = queue->readyNodes[queue->head];
+		queue->head++;
+		pthread_mutex_unlock(&queue->mutex);
+
+		AlignStatus status = mergeChildren(aligner, queue->nodes, node);
+
+		pthread_mutex_lock(&queue->mutex);
+		queue->numOfRemainingNodes--;
+		int parent = queue->nodes[node].parent;
+		if(status != ALIGN_SUCCESS)
+		{
+			queue->status = status;
+		}
+		else if(parent != NO_NODE)
+		{
+			queue->nodes[parent].numOfPendingChildren--;
+			if(queue->nodes[parent].numOfPendingChildren == 0)
+			{
+				queue->readyNodes[queue->tail] = parent;
+				queue->tail++;
+			}
+		}
+		pthread_cond_broadcast(&queue->nodeIsReady);
+	}
+
+	pthread_mutex_unlock(&queue->mutex);
+	freeAligner(&aligner);
+
+	return NULL;
+}
+
+/**
+ * This function merges all the internal nodes of the guide tree, bottom up, by numOfThreads
+ * threads (the calling thread is one of them).
+ * @param aligner - the aligner, whose scores the profiles are aligned by.
+ * @param nodes - the nodes of the guide tree.
+ * @param numOfStrs - the number of strings (leaves).
+ * @param numOfThreads - the number of threads.
+ * @return ALIGN_SUCCESS, or the status of the first failure.
+ */
+static AlignStatus mergeGuideTree(const Aligner* aligner, TreeNode *nodes, const int numOfStrs,
+								  int numOfThreads)
+{
+	int numOfInternalNodes = numOfStrs - 1;
+	MergeQueue queue;
+	int node;
+
+	queue.aligner = aligner;
+	queue.nodes = nodes;
+	queue.readyNodes = (int*) malloc((size_t) numOfStrs * sizeof(int));
+	queue.head = 0;
+	queue.tail = 0;
+	queue.numOfRemainingNodes = numOfInternalNodes;
+	queue.status = ALIGN_SUCCESS;
+	if(queue.readyNodes == NULL)
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	for(node = numOfStrs ; node < numOfStrs + numOfInternalNodes ; node++)
+	{
+		if(nodes[node].numOfPendingChildren == 0)
+		{
+			queue.readyNodes[queue.tail] = node;
+			queue.tail++;
+		}
+	}
+
+	if(numOfThreads > numOfInternalNodes)
+	{
+		numOfThreads = numOfInternalNodes;
+	}
+	pthread_t *threads = (pthread_t*) malloc((size_t) numOfThreads * sizeof(pthread_t) + 1);
+	if(threads == NULL)
+	{
+		free(queue.readyNodes);
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	pthread_mutex_init(&queue.mutex, NULL);
+	pthread_cond_init(&queue.nodeIsReady, NULL);
+
+	//if a thread can't be created, the merges are shared by fewer threads.
+	int numOfStartedThreads = 0;
+	while(numOfStartedThreads < numOfThreads - 1 &&
+		  pthread_create(&threads[numOfStartedThreads], NULL, mergeReadyNodes, &queue) == 0)
+	{
+		numOfStartedThreads++;
+	}
+	mergeReadyNodes(&queue);
+
+	int k;
+	for(k = 0 ; k < numOfStartedThreads ; k++)
+	{
+		pthread_join(threads[k], NULL);
+	}
+
+	pthread_cond_destroy(&queue.nodeIsReady);
+	pthread_mutex_destroy(&queue.mutex);
+	free(threads);
+	free(queue.readyNodes);
+
+	return queue.status;
+}
+
+/**
+ * This function calculates a multiple alignment of strings progressively: it builds a guide tree
+ * of the strings by UPGMA on their pairwise scores, and then aligns the profiles of the children
+ * of every node of the tree into its profile, bottom up, where the nodes of independent subtrees
+ * are aligned in parallel. The result doesn't depend on the number of threads.
+ * @param aligner - the aligner, whose scores the profiles are aligned by (it isn't changed, every
+ *                  thread aligns with a clone of it).
+ * @param strs - the strings of residue letters.
+ * @param sizes - the sizes of the strings.
+ * @param numOfStrs - the number of strings.
+ * @param scores - the pairwise scores of the strings: scores[i * numOfStrs + j] is the score of
+ *                 the alignment of strings i and j, and scores[i * numOfStrs + i] the score of
+ *                 the alignment of string i to itself.
+ * @param numOfThreads - the number of threads.
+ * @param multipleAlignment - output: the multiple alignment, which is freed by
+ *                            freeMultipleAlignment.
+ * @return ALIGN_SUCCESS, ALIGN_ERROR_NO_MEMORY, ALIGN_ERROR_INVALID_ARGUMENT or
+ *         ALIGN_ERROR_INVALID_RESIDUE.
+ */
+AlignStatus alignMultiple(const Aligner* aligner, const char *const *strs, const int *sizes,
+						  int numOfStrs, const int *scores, int numOfThreads,
+						  MultipleAlignment *multipleAlignment)
+{
+	if(aligner == NULL || strs == NULL || sizes == NULL || scores == NULL ||
+	   multipleAlignment == NULL || numOfStrs < 1 || numOfThreads < 1 ||
+	   (size_t) numOfStrs > SIZE_MAX / 2 / sizeof(TreeNode))
+	{
+		return ALIGN_ERROR_INVALID_ARGUMENT;
+	}
+
+	int numOfNodes = 2 * numOfStrs - 1;
+	TreeNode *nodes = (TreeNode*) calloc((size_t) numOfNodes, sizeof(TreeNode));
+	if(nodes == NULL)
+	{
+		return ALIGN_ERROR_NO_MEMORY;
+	}
+
+	int node;
+	for(node = 0 ; node < numOfNodes ; node++)
+	{
+		nodes[node].parent = NO_NODE;
+		if(node < numOfStrs)
+		{
+			nodes[node].left = NO_NODE;
+			nodes[node].right = NO_NODE;
+			nodes[node].str = node;
+			nodes[node].members = &nodes[node].str;
+			nodes[node].profile.rows = strs[node];
+			nodes[node].profile.numOfRows = 1;
+			nodes[node].profile.numOfCols = sizes[node];
+		}
+	}
+
+	AlignStatus status = buildGuideTree(scores, numOfStrs, nodes);
+	if(status == ALIGN_SUCCESS && numOfStrs > 1)
+	{
+		status = mergeGuideTree(aligner, nodes, numOfStrs, numOfThreads);
+	}
+
+	const Profile *root = &nodes[numOfNodes - 1].profile;
+	size_t rowSize = (size_t) root->numOfCols + 1;
+	multipleAlignment->rows = NULL;
+	if(status == ALIGN_SUCCESS && (size_t) numOfStrs > SIZE_MAX / rowSize)
+	{
+		status = ALIGN_ERROR_NO_MEMORY;
+	}
+	if(status == ALIGN_SUCCESS)
+	{
+		multipleAlignment->rows = (char*) malloc((size_t) numOfStrs * rowSize);
+		status = (multipleAlignment->rows == NULL) ? ALIGN_ERROR_NO_MEMORY : ALIGN_SUCCESS;
+	}
+
+	if(status == ALIGN_SUCCESS)
+	{
+		int row;
+		for(row = 0 ; row < numOfStrs ; row++)
+		{
+			char *alignedRow = multipleAlignment->rows +
+							   (size_t) nodes[numOfNodes - 1].members[row] * rowSize;
+			memcpy(alignedRow, root->rows + (size_t) row * root->numOfCols,
+				   (size_t) root->numOfCols);
+			alignedRow[root->numOfCols] = EMPTY_CHAR;
+		}
+		multipleAlignment->numOfRows = numOfStrs;
+		multipleAlignment->numOfCols = root->numOfCols;
+	}
+
+	for(node = 0 ; node < numOfNodes ; node++)
+	{
+		freeProfileOfNode(&nodes[node]);
+	}
+	free(nodes);
+
+	return status;
+}
+
+/**
+ * This function frees the rows of a multiple alignment.
+ * @param multipleAlignment - the multiple alignment.
+ */
+void freeMultipleAlignment(MultipleAlignment *multipleAlignment)
+{
+	free(multipleAlignment->rows);
+	multipleAlignment->rows = NULL;
+	multipleAlignment->numOfRows = 0;
+	multipleAlignment->numOfCols = 0;
+}
@@ -0,0 +1,24 @@
+#ifndef MSA_H
+#define MSA_H
+
+#include "align.h"
+
+/**
+ * This struct represents a multiple alignment: a row for every string, in the order of the
+ * strings, each one numOfCols residue letters and GAP_CHAR long and null terminated. Row i is at
+ * rows + i * (numOfCols + 1).
+ */
+typedef struct MultipleAlignment
+{
+	char *rows;
+	int numOfRows;
+	int numOfCols;
+} MultipleAlignment;
+
+AlignStatus alignMultiple(const Aligner* aligner, const char *const *strs, const int *sizes,
+						  int numOfStrs, const int *scores, int numOfThreads,
+						  MultipleAlignment *multipleAlignment);
+
+void freeMultipleAlignment(MultipleAlignment *multipleAlignment);
+
+#endif
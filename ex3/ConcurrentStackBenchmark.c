@@ -0,0 +1,347 @@
+//================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "stack.h"
+#include "concurrentstack.h"
+//================================ Constants ====================================================
+#define NUMBER_OF_ARGS 3
+#define INDEX_OF_THREADS_ARGUMENT 1
+#define INDEX_OF_COUNT_ARGUMENT 2
+#define BASE_OF_COUNTING 10
+#define EMPTY_CHAR '\0'
+#define MAX_NUM_OF_THREADS 256
+#define NANOSECONDS_PER_SECOND 1e9
+#define OPERATIONS_PER_MEGA_OPERATION 1e6
+#define ARGS_ERROR "Error of usage: ConcurrentStackBenchmark <threads> <pushes per thread>\n"
+#define INVALID_ARGUMENT_ERROR "Error of usage: invalid argument %s\n"
+#define ERROR_NOT_ENOUGH_MEMORY "ERROR - Not enough memory!!!"
+#define THREAD_ERROR "Error creating a thread\n"
+#define FULL_STACK_ERROR "Error: the concurrent stack is full\n"
+#define PRINT_SETTINGS_LINE "%d threads, %ld pushes and pops per thread\n\n"
+#define PRINT_TABLE_HEADER "%-12s %10s %10s %8s\n"
+#define PRINT_TABLE_ROW "%-12s %10.3f %10.2f %8s\n"
+#define STACK_TITLE "stack"
+#define SECONDS_TITLE "seconds"
+#define MOPS_TITLE "Mops/s"
+#define CHECK_TITLE "check"
+#define CONCURRENT_STACK_NAME "lock-free"
+#define MUTEX_STACK_NAME "mutex"
+#define CHECK_PASSED "ok"
+#define CHECK_FAILED "FAILED"
+#define CHECK_FAILED_ERROR "Error: the %s stack lost or duplicated %ld values\n"
+
+//================================ Code Segment =================================================
+
+/**
+ * This struct represents a libstack stack with a mutex, the way we shared stacks between threads
+ * before the concurrent stack.
+ */
+typedef struct MutexStack
+{
+	Stack *stack;
+	pthread_mutex_t mutex;
+} MutexStack;
+
+/**
+ * This struct represents the work of a thread of the benchmark: it pushes the values
+ * firstValue to firstValue + count - 1, and pops after every push, to its popped values.
+ */
+typedef struct BenchmarkThread
+{
+	ConcurrentStack *concurrentStack;
+	MutexStack *mutexStack;
+	int firstValue;
+	long count;
+	int *poppedValues;
+	long numOfPoppedValues;
+} BenchmarkThread;
+
+/**
+ * This function returns the time of a monotonic clock, in seconds.
+ * @return the time.
+ */
+double currentSeconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + (double) now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * This function checks that a memory allocation succeeded, and exits with an error otherwise.
+ * @param p - the allocated memory.
+ */
+void nullPointerCheckerForAllocatedMemory(const void *p)
+{
+	if(p == NULL)
+	{
+		fprintf(stderr, ERROR_NOT_ENOUGH_MEMORY);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function is the work of a thread on the concurrent stack.
+ * @param arg - the BenchmarkThread of the thread.
+ * @return NULL.
+ */
+void *runConcurrentThread(void *arg)
+{
+	BenchmarkThread *thread = (BenchmarkThread*) arg;
+	long i;
+	for(i = 0 ; i < thread->count ; i++)
+	{
+		int value = thread->firstValue + (int) i;
+		if(!concurrentPush(thread->concurrentStack, &value))
+		{
+			fprintf(stderr, FULL_STACK_ERROR);
+			exit(EXIT_FAILURE);
+		}
+		if(concurrentPop(thread->concurrentStack, &value))
+		{
+			thread->poppedValues[thread->numOfPoppedValues++] = value;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * This function is the work of a thread on the stack with a mutex.
+ * @param arg - the BenchmarkThread of the thread.
+ * @return NULL.
+ */
+void *runMutexThread(void *arg)
+{
+	BenchmarkThread *thread = (BenchmarkThread*) arg;
+	MutexStack *mutexStack = thread->mutexStack;
+	long i;
+	for(i = 0 ; i < thread->count ; i++)
+	{
+		int value = thread->firstValue + (int) i;
+		pthread_mutex_lock(&mutexStack->mutex);
+		push(mutexStack->stack, &value);
+		pthread_mutex_unlock(&mutexStack->mutex);
+
+		pthread_mutex_lock(&mutexStack->mutex);
+		int isPopped = !isEmptyStack(mutexStack->stack);
+		if(isPopped)
+		{
+			pop(mutexStack->stack, &value);
+		}
+		pthread_mutex_unlock(&mutexStack->mutex);
+		if(isPopped)
+		{
+			thread->poppedValues[thread->numOfPoppedValues++] = value;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * This function runs the threads of the benchmark, and waits for all of them.
+ * @param threads - the threads.
+ * @param numOfThreads - the number of threads.
+ * @param run - the work of every thread.
+ * @return the time it took, in seconds.
+ */
+double runThreads(BenchmarkThread *threads, int numOfThreads, void *(*run)(void *))
+{
+	pthread_t ids[MAX_NUM_OF_THREADS];
+	int i;
+	double start = currentSeconds();
+	for(i = 0 ; i < numOfThreads ; i++)
+	{
+		if(pthread_create(&ids[i], NULL, run, &threads[i]) != 0)
+		{
+			fprintf(stderr, THREAD_ERROR);
+			exit(EXIT_FAILURE);
+		}
+	}
+	for(i = 0 ; i < numOfThreads ; i++)
+	{
+		pthread_join(ids[i], NULL);
+	}
+	return currentSeconds() - start;
+}
+
+/**
+ * This function is the stress check of a stack: every pushed value (0 to numOfValues - 1) must be
+ * popped exactly once, by the threads or by popping the rest of the stack after them.
+ * @param threads - the threads.
+ * @param numOfThreads - the number of threads.
+ * @param restOfStack - the values popped after the threads.
+ * @param restSize - the number of values popped after the threads.
+ * @param numOfValues - the number of pushed values.
+ * @return the number of values which weren't popped exactly once.
+ */
+long checkPoppedValues(const BenchmarkThread *threads, int numOfThreads, const int *restOfStack,
+					   long restSize, long numOfValues)
+{
+	unsigned char *timesPopped = (unsigned char*) calloc((size_t) numOfValues, sizeof(char));
+	nullPointerCheckerForAllocatedMemory(timesPopped);
+	long numOfErrors = 0;
+	long i;
+	int t;
+
+	for(t = 0 ; t <= numOfThreads ; t++)
+	{
+		const int *values = (t < numOfThreads) ? threads[t].poppedValues : restOfStack;
+		long size = (t < numOfThreads) ? threads[t].numOfPoppedValues : restSize;
+		for(i = 0 ; i < size ; i++)
+		{
+			if(values[i] < 0 || values[i] >= numOfValues || timesPopped[values[i]] > 0)
+			{
+				numOfErrors++;
+			}
+			else
+			{
+				timesPopped[values[i]] = 1;
+			}
+		}
+	}
+	for(i = 0 ; i < numOfValues ; i++)
+	{
+		if(timesPopped[i] == 0)
+		{
+			numOfErrors++;
+		}
+	}
+
+	free(timesPopped);
+	return numOfErrors;
+}
+
+/**
+ * This function prints a row of the results table, and exits with an error if the stress check
+ * failed.
+ * @param stackName - the name of the stack.
+ * @param seconds - the time of the threads.
+ * @param numOfOperations - the number of pushes and pops of all the threads.
+ * @param numOfErrors - the result of the stress check.
+ */
+void printResultRow(const char *stackName, double seconds, double numOfOperations,
+					long numOfErrors)
+{
+	printf(PRINT_TABLE_ROW, stackName, seconds,
+		   numOfOperations / seconds / OPERATIONS_PER_MEGA_OPERATION,
+		   (numOfErrors == 0) ? CHECK_PASSED : CHECK_FAILED);
+	if(numOfErrors > 0)
+	{
+		fprintf(stderr, CHECK_FAILED_ERROR, stackName, numOfErrors);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function prepares the threads of a run, and clears their popped values.
+ * @param threads - the threads.
+ * @param numOfThreads - the number of threads.
+ * @param count - the number of pushes of every thread.
+ * @param concurrentStack - the concurrent stack, or NULL.
+ * @param mutexStack - the stack with a mutex, or NULL.
+ */
+void prepareThreads(BenchmarkThread *threads, int numOfThreads, long count,
+					ConcurrentStack *concurrentStack, MutexStack *mutexStack)
+{
+	int i;
+	for(i = 0 ; i < numOfThreads ; i++)
+	{
+		threads[i].concurrentStack = concurrentStack;
+		threads[i].mutexStack = mutexStack;
+		threads[i].firstValue = (int) (i * count);
+		threads[i].count = count;
+		threads[i].numOfPoppedValues = 0;
+	}
+}
+
+/**
+ * This is the main function of the benchmark. Every thread pushes its values to a shared stack and
+ * pops after every push (the pops of all the threads contend with the pushes), first on the
+ * lock-free concurrent stack and then on a libstack stack with a mutex. It prints the throughput
+ * of each one, and checks that every pushed value was popped exactly once.
+ * @param argc arguments counter.
+ * @param argv arguments values.
+ * @return 0 if succeeds, 1 otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	if(argc != NUMBER_OF_ARGS)
+	{
+		fprintf(stderr, ARGS_ERROR);
+		exit(EXIT_FAILURE);
+	}
+
+	char *end;
+	long numOfThreads = strtol(argv[INDEX_OF_THREADS_ARGUMENT], &end, BASE_OF_COUNTING);
+	if(*end != EMPTY_CHAR || numOfThreads < 1 || numOfThreads > MAX_NUM_OF_THREADS)
+	{
+		fprintf(stderr, INVALID_ARGUMENT_ERROR, argv[INDEX_OF_THREADS_ARGUMENT]);
+		exit(EXIT_FAILURE);
+	}
+	long count = strtol(argv[INDEX_OF_COUNT_ARGUMENT], &end, BASE_OF_COUNTING);
+	if(*end != EMPTY_CHAR || count < 1 || count > INT32_MAX / numOfThreads)
+	{
+		fprintf(stderr, INVALID_ARGUMENT_ERROR, argv[INDEX_OF_COUNT_ARGUMENT]);
+		exit(EXIT_FAILURE);
+	}
+
+	long numOfValues = numOfThreads * count;
+	double numOfOperations = 2.0 * (double) numOfValues;
+	BenchmarkThread threads[MAX_NUM_OF_THREADS];
+	int i;
+	for(i = 0 ; i < numOfThreads ; i++)
+	{
+		threads[i].poppedValues = (int*) malloc((size_t) count * sizeof(int));
+		nullPointerCheckerForAllocatedMemory(threads[i].poppedValues);
+	}
+	int *restOfStack = (int*) malloc((size_t) numOfValues * sizeof(int));
+	nullPointerCheckerForAllocatedMemory(restOfStack);
+	long restSize;
+
+	printf(PRINT_SETTINGS_LINE, (int) numOfThreads, count);
+	printf(PRINT_TABLE_HEADER, STACK_TITLE, SECONDS_TITLE, MOPS_TITLE, CHECK_TITLE);
+
+	//a pop may miss (the stack may be empty for it), so the stack can hold all the values.
+	ConcurrentStack *concurrentStack = concurrentStackAlloc(sizeof(int), (size_t) numOfValues);
+	nullPointerCheckerForAllocatedMemory(concurrentStack);
+	prepareThreads(threads, (int) numOfThreads, count, concurrentStack, NULL);
+	double seconds = runThreads(threads, (int) numOfThreads, runConcurrentThread);
+	restSize = 0;
+	while(concurrentPop(concurrentStack, &restOfStack[restSize]))
+	{
+		restSize++;
+	}
+	printResultRow(CONCURRENT_STACK_NAME, seconds, numOfOperations,
+				   checkPoppedValues(threads, (int) numOfThreads, restOfStack, restSize,
+									 numOfValues));
+	freeConcurrentStack(&concurrentStack);
+
+	MutexStack mutexStack;
+	mutexStack.stack = stackAlloc(sizeof(int));
+	nullPointerCheckerForAllocatedMemory(mutexStack.stack);
+	pthread_mutex_init(&mutexStack.mutex, NULL);
+	prepareThreads(threads, (int) numOfThreads, count, NULL, &mutexStack);
+	seconds = runThreads(threads, (int) numOfThreads, runMutexThread);
+	restSize = 0;
+	while(!isEmptyStack(mutexStack.stack))
+	{
+		pop(mutexStack.stack, &restOfStack[restSize]);
+		restSize++;
+	}
+	printResultRow(MUTEX_STACK_NAME, seconds, numOfOperations,
+				   checkPoppedValues(threads, (int) numOfThreads, restOfStack, restSize,
+									 numOfValues));
+	pthread_mutex_destroy(&mutexStack.mutex);
+	freeStack(&mutexStack.stack);
+
+	for(i = 0 ; i < numOfThreads ; i++)
+	{
+		free(threads[i].poppedValues);
+	}
+	free(restOfStack);
+
+	return 0;
+}
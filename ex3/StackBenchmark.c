@@ -0,0 +1,281 @@
+//================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stack.h"
+#include "typedstack.h"
+//================================ Constants ====================================================
+#define NUMBER_OF_ARGS 2
+#define INDEX_OF_COUNT_ARGUMENT 1
+#define BASE_OF_COUNTING 10
+#define EMPTY_CHAR '\0'
+#define NUMBER_OF_ROUNDS 5
+#define NANOSECONDS_PER_SECOND 1e9
+#define ARGS_ERROR "Error of usage: StackBenchmark <number of elements>\n"
+#define INVALID_ARGUMENT_ERROR "Error of usage: invalid argument %s\n"
+#define ERROR_NOT_ENOUGH_MEMORY "ERROR - Not enough memory!!!"
+#define PRINT_SETTINGS_LINE "%ld ints, %d rounds\n\n"
+#define PRINT_TABLE_HEADER "%-16s %-10s %10s %10s %14s\n"
+#define PRINT_TABLE_ROW "%-16s %-10s %10.3f %10.2f %14lld\n"
+#define STACK_TITLE "stack"
+#define PATTERN_TITLE "pattern"
+#define SECONDS_TITLE "seconds"
+#define NS_PER_OP_TITLE "ns/op"
+#define CHECKSUM_TITLE "checksum"
+#define ARRAY_STACK_NAME "libstack array"
+#define LINKED_STACK_NAME "libstack linked"
+#define POOLED_STACK_NAME "libstack pooled"
+#define TYPED_STACK_NAME "typed"
+#define FILL_PATTERN_NAME "fill"
+#define MIXED_PATTERN_NAME "mixed"
+
+//================================ Code Segment =================================================
+
+/**
+ * This is the typed stack of the benchmark.
+ */
+DEFINE_STACK(IntStack, int)
+
+/**
+ * This function returns the time of a monotonic clock, in seconds.
+ * @return the time.
+ */
+double currentSeconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + (double) now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * This function pushes count ints to a libstack stack, and then pops all of them.
+ * @param stack - the stack.
+ * @param count - the number of ints.
+ * @return the sum of the popped ints.
+ */
+long long fillLibstack(Stack *stack, long count)
+{
+	long long sum = 0;
+	long i;
+	for(i = 0 ; i < count ; i++)
+	{
+		int value = (int) i;
+		push(stack, &value);
+	}
+	while(!isEmptyStack(stack))
+	{
+		int value;
+		pop(stack, &value);
+		sum += value;
+	}
+	return sum;
+}
+
+/**
+ * This function pushes two ints to a libstack stack and pops one, count times (the stack grows
+ * by one every time, like the operands of a long postfix expression), and then pops all of them.
+ * @param stack - the stack.
+ * @param count - the number of times.
+ * @return the sum of the popped ints.
+ */
+long long mixLibstack(Stack *stack, long count)
+{
+	long long sum = 0;
+	long i;
+	for(i = 0 ; i < count ; i++)
+	{
+		int value = (int) i;
+		push(stack, &value);
+		push(stack, &value);
+		pop(stack, &value);
+		sum += value;
+	}
+	while(!isEmptyStack(stack))
+	{
+		int value;
+		pop(stack, &value);
+		sum += value;
+	}
+	return sum;
+}
+
+/**
+ * This function checks if a push to a typed stack succeeded.
+ * @param isPushed - the result of the push.
+ */
+void checkPush(const int isPushed)
+{
+	if(!isPushed)
+	{
+		fprintf(stderr, ERROR_NOT_ENOUGH_MEMORY);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * This function pushes count ints to a typed stack, and then pops all of them.
+ * @param stack - the stack.
+ * @param count - the number of ints.
+ * @return the sum of the popped ints.
+ */
+long long fillTypedStack(IntStack *stack, long count)
+{
+	long long sum = 0;
+	long i;
+	for(i = 0 ; i < count ; i++)
+	{
+		checkPush(IntStackPush(stack, (int) i));
+	}
+	while(!IntStackIsEmpty(stack))
+	{
+		sum += IntStackPop(stack);
+	}
+	return sum;
+}
+
+/**
+ * This function pushes two ints to a typed stack and pops one, count times, and then pops all of
+ * them.
+ * @param stack - the stack.
+ * @param count - the number of times.
+ * @return the sum of the popped ints.
+ */
+long long mixTypedStack(IntStack *stack, long count)
+{
+	long long sum = 0;
+	long i;
+	for(i = 0 ; i < count ; i++)
+	{
+		checkPush(IntStackPush(stack, (int) i));
+		checkPush(IntStackPush(stack, (int) i));
+		sum += IntStackPop(stack);
+	}
+	while(!IntStackIsEmpty(stack))
+	{
+		sum += IntStackPop(stack);
+	}
+	return sum;
+}
+
+/**
+ * This function prints a row of the results table.
+ * @param stackName - the name of the stack.
+ * @param patternName - the name of the pattern of pushes and pops.
+ * @param seconds - the time of all the rounds.
+ * @param numOfOperations - the number of pushes and pops of all the rounds.
+ * @param checksum - the sum of the popped ints, so the work can't be optimized away.
+ */
+void printResultRow(const char *stackName, const char *patternName, double seconds,
+					double numOfOperations, long long checksum)
+{
+	printf(PRINT_TABLE_ROW, stackName, patternName, seconds,
+		   seconds * NANOSECONDS_PER_SECOND / numOfOperations, checksum);
+}
+
+/**
+ * This function runs the benchmark of a libstack stack: every pattern, NUMBER_OF_ROUNDS times,
+ * on the same stack (so after the first round, an array backed stack doesn't grow).
+ * @param stack - the stack.
+ * @param stackName - the name of the stack.
+ * @param count - the number of elements.
+ */
+void benchmarkLibstack(Stack *stack, const char *stackName, long count)
+{
+	long long checksum = 0;
+	int round;
+
+	double start = currentSeconds();
+	for(round = 0 ; round < NUMBER_OF_ROUNDS ; round++)
+	{
+		checksum += fillLibstack(stack, count);
+	}
+	printResultRow(stackName, FILL_PATTERN_NAME, currentSeconds() - start,
+				   2.0 * count * NUMBER_OF_ROUNDS, checksum);
+
+	checksum = 0;
+	start = currentSeconds();
+	for(round = 0 ; round < NUMBER_OF_ROUNDS ; round++)
+	{
+		checksum += mixLibstack(stack, count);
+	}
+	printResultRow(stackName, MIXED_PATTERN_NAME, currentSeconds() - start,
+				   4.0 * count * NUMBER_OF_ROUNDS, checksum);
+}
+
+/**
+ * This function runs the benchmark of the typed stack, like benchmarkLibstack.
+ * @param count - the number of elements.
+ */
+void benchmarkTypedStack(long count)
+{
+	IntStack stack;
+	IntStackInit(&stack);
+	long long checksum = 0;
+	int round;
+
+	double start = currentSeconds();
+	for(round = 0 ; round < NUMBER_OF_ROUNDS ; round++)
+	{
+		checksum += fillTypedStack(&stack, count);
+	}
+	printResultRow(TYPED_STACK_NAME, FILL_PATTERN_NAME, currentSeconds() - start,
+				   2.0 * count * NUMBER_OF_ROUNDS, checksum);
+
+	checksum = 0;
+	start = currentSeconds();
+	for(round = 0 ; round < NUMBER_OF_ROUNDS ; round++)
+	{
+		checksum += mixTypedStack(&stack, count);
+	}
+	printResultRow(TYPED_STACK_NAME, MIXED_PATTERN_NAME, currentSeconds() - start,
+				   4.0 * count * NUMBER_OF_ROUNDS, checksum);
+
+	IntStackFree(&stack);
+}
+
+/**
+ * This is the main function of the benchmark. It compares the pushes and pops of ints of the
+ * libstack stacks (array backed, linked and pooled linked, which copy every element with memcpy)
+ * with those of a typed stack (typedstack.h), and prints the time of each one, in ns per push or
+ * pop.
+ * @param argc arguments counter.
+ * @param argv arguments values.
+ * @return 0 if succeeds, 1 otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	if(argc != NUMBER_OF_ARGS)
+	{
+		fprintf(stderr, ARGS_ERROR);
+		exit(EXIT_FAILURE);
+	}
+
+	char *end;
+	long count = strtol(argv[INDEX_OF_COUNT_ARGUMENT], &end, BASE_OF_COUNTING);
+	if(*end != EMPTY_CHAR || count < 1)
+	{
+		fprintf(stderr, INVALID_ARGUMENT_ERROR, argv[INDEX_OF_COUNT_ARGUMENT]);
+		exit(EXIT_FAILURE);
+	}
+
+	printf(PRINT_SETTINGS_LINE, count, NUMBER_OF_ROUNDS);
+	printf(PRINT_TABLE_HEADER, STACK_TITLE, PATTERN_TITLE, SECONDS_TITLE, NS_PER_OP_TITLE,
+		   CHECKSUM_TITLE);
+
+	Stack *arrayStack = stackAlloc(sizeof(int));
+	benchmarkLibstack(arrayStack, ARRAY_STACK_NAME, count);
+	freeStack(&arrayStack);
+
+	Stack *linkedStack = linkedStackAlloc(sizeof(int));
+	benchmarkLibstack(linkedStack, LINKED_STACK_NAME, count);
+	freeStack(&linkedStack);
+
+	Stack *pooledStack = pooledLinkedStackAlloc(sizeof(int));
+	benchmarkLibstack(pooledStack, POOLED_STACK_NAME, count);
+	freeStack(&pooledStack);
+
+	benchmarkTypedStack(count);
+
+	return 0;
+}
@@ -1,19 +1,34 @@
 //================================ Includes =====================================================
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <math.h>
+#include <limits.h>
 #include <ctype.h>
-#include "stack.h"
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "typedstack.h"
 //================================ Constants ====================================================
+//the type of the results: int, or 64 bit integers if compiled with -DCALC_INT_64 (make calc64).
+#ifdef CALC_INT_64
+typedef int64_t CalcInt;
+#define CALC_INT_MAX INT64_MAX
+#define CALC_INT_FORMAT "%" PRId64
+#else
+typedef int CalcInt;
+#define CALC_INT_MAX INT_MAX
+#define CALC_INT_FORMAT "%d"
+#endif
 #define ERROR_NOT_ENOUGH_MEMORY "ERROR - Not enough memory!!!"
 #define DIVISION_BY_ZERO "Division by 0!\n"
+#define OVERFLOW "Overflow!\n"
 #define POSTFIX_TITLE "Postfix: "
 #define INFIX_TITLE "Infix: "
-#define PRINT_RESULT "The value is %d\n"
-#define NUMBER_PRINT_PATTERN " %s "
-#define OPERATOR_AND_PARENTHESIS_PRINT_PATTERN "%s"
+#define PRINT_RESULT "The value is " CALC_INT_FORMAT "\n"
 #define NEW_LINE "\n"
 #define PLUS_CHAR '+'
 #define MINUS_CHAR '-'
@@ -23,19 +38,158 @@
 #define LEFT_PARENTHESIS_CHAR '('
 #define RIGHT_PARENTHESIS_CHAR ')'
 #define EMPTY_CHAR '\0'
-#define MAX_SIZE_OF_EXPRESSION 102
+#define INITIAL_NUM_OF_TOKENS 128
+#define MAX_CACHED_EXPRESSION_LENGTH 4096
 #define BASE_OF_COUNTING 10
 #define TRUE 1
 #define FALSE 0
 #define PRECEDENCE_SCORE_FOR_POWER_OPERATOR 3
 #define PRECEDENCE_SCORE_FOR_MULTIPLY_OR_DIVIDE_OPERATOR 2
 #define PRECEDENCE_SCORE_FOR_PLUS_OR_MINUS_OPERATOR 1
-#define FIRST_CHAR_INDEX 0
-#define SECOND_CHAR_INDEX 1
+#define NUMBER_TOKEN_PRINT_PATTERN " %.*s "
 #define INTEGER_TO_THE_POWER_OF_ZERO 1
+#define ODD_MASK 1
 #define DUMMY_VALUE 0
+#define NUMBER_PRINT_EXTRA_LENGTH 2
+#define INITIAL_CACHE_CAPACITY 64
+#define MAX_CACHED_EXPRESSIONS 65536
+#define CACHE_GROWTH_FACTOR 2
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+#define BATCH_OPTION "--batch"
+#define RESULTS_ONLY_OPTION "--results-only"
+#define THREADS_OPTION "-j"
+#define BATCH_CHUNK_SIZE 262144
+#define INITIAL_OUTPUT_CAPACITY 131072
+#define MAX_NUM_OF_THREADS 256
+#define CHUNKS_PER_THREAD 2
+#define NEW_LINE_CHAR '\n'
+#define CARRIAGE_RETURN_CHAR '\r'
+#define NANOSECONDS_PER_SECOND 1e9
+#define PRINT_INFIX_AND_POSTFIX INFIX_TITLE "%s" NEW_LINE POSTFIX_TITLE "%s" NEW_LINE
+#define PRINT_RESULT_ONLY CALC_INT_FORMAT "\n"
+#define PRINT_LINE_ERROR "Error in line %ld: %s"
+#define PRINT_BATCH_STATISTICS "%ld expressions in %.3f seconds (%.0f expressions/sec)\n"
+#define ARGS_ERROR "Error of usage: calc [--batch] [-j <threads>] [--results-only]\n"
+#define THREAD_ERROR "Error creating a thread\n"
 //================================ Code Segment =================================================
 
+/**
+ * These are the typed stacks of the conversion to postfix (of operators and parentheses) and of
+ * the calculation of the postfix expression (of integers), which push and pop by value.
+ */
+DEFINE_STACK(CharStack, char)
+DEFINE_STACK(IntStack, CalcInt)
+
+/**
+ * These are the results of calculations.
+ */
+typedef enum CalculationStatus
+{
+	CALCULATION_SUCCESS,
+	CALCULATION_DIVISION_BY_ZERO,
+	CALCULATION_OVERFLOW
+} CalculationStatus;
+
+/**
+ * These are the kinds of the tokens of an expression.
+ */
+typedef enum TokenKind
+{
+	NUMBER_TOKEN,
+	OPERATOR_TOKEN,
+	PARENTHESIS_TOKEN
+} TokenKind;
+
+/**
+ * This struct represents a token of an expression (infix or postfix): a number, with its value (or
+ * isTooBig, if it's bigger than CALC_INT_MAX) and its span in the input expression, or an operator
+ * or a parenthesis char.
+ */
+typedef struct Token
+{
+	char kind;
+	char operation;
+	char isTooBig;
+	CalcInt value;
+	size_t start;
+	int length;
+} Token;
+
+/**
+ * This struct represents the workspace of compiling expressions: the tokens of the infix and the
+ * postfix expressions (room for maxNumOfTokens each) and the stack of the conversion, which are
+ * reused for every expression and grow only for an expression longer than all the ones before, so
+ * tokenizing an expression and converting it to postfix usually don't allocate.
+ */
+typedef struct CompileWorkspace
+{
+	Token *infixExpression;
+	Token *postfixExpression;
+	size_t maxNumOfTokens;
+	CharStack charStack;
+} CompileWorkspace;
+
+/**
+ * These are the operations of a compiled expression.
+ */
+typedef enum OpCode
+{
+	PUSH_NUMBER,
+	PUSH_TOO_BIG_NUMBER,
+	ADD,
+	SUBTRACT,
+	MULTIPLY,
+	DIVIDE,
+	POWER
+} OpCode;
+
+/**
+ * This struct represents an instruction of a compiled expression: push its number, or pop two
+ * integers and push the result of its binary operation.
+ */
+typedef struct Instruction
+{
+	char opCode;
+	CalcInt number;
+} Instruction;
+
+/**
+ * This struct represents an expression which was compiled once: its infix and postfix forms, as
+ * they are printed, and the instructions which calculate its value (the postfix expression, with
+ * its numbers already parsed). All of them are in one allocation, which starts with the
+ * instructions.
+ */
+typedef struct CompiledExpression
+{
+	char *infixText;
+	char *postfixText;
+	Instruction *code;
+	int sizeOfCode;
+} CompiledExpression;
+
+/**
+ * This struct represents an entry of the expressions cache: an input expression (NULL if the
+ * entry is empty) and its compiled form.
+ */
+typedef struct CacheEntry
+{
+	char *expression;
+	CompiledExpression compiled;
+} CacheEntry;
+
+/**
+ * This struct represents the cache of the compiled expressions, which is a hash table keyed by the
+ * text of the input expression (with open addressing), so an expression which repeats is compiled
+ * only once.
+ */
+typedef struct ExpressionCache
+{
+	CacheEntry *entries;
+	size_t capacity;
+	size_t size;
+} ExpressionCache;
+
 /**
  * This function checks if a given pointer is a NULL pointer.
  * @param pointerToCheck - the input pointer.
@@ -49,6 +203,20 @@ void nullPointerCheckerForAllocatedMemory(const void *pointerToCheck)
 	}
 }
 
+/**
+ * This function checks if a push to a stack succeeded (it fails only if there's not enough
+ * memory for the stack to grow).
+ * @param isPushed - the result of the push.
+ */
+void checkPush(const int isPushed)
+{
+	if(!isPushed)
+	{
+		fprintf(stderr, ERROR_NOT_ENOUGH_MEMORY);
+		exit(EXIT_FAILURE);
+	}
+}
+
 /**
  * This function checks if a given char is equal to right or left parenthesis.
  * @param c - the input char.
@@ -114,81 +282,127 @@ int compareOperators(const char op1, const char op2)
 }
 
 /**
- * This function calculates integer b by the power of integer a.
+ * This function calculates integer b by the power of integer a, by squaring. A negative exponent
+ * gives 1 / b ^ -a, truncated like the division of integers.
  * @param base - first integer.
  * @param exponent - second integer.
- * @return b ^ a
+ * @param result - output: b ^ a.
+ * @return CALCULATION_SUCCESS, CALCULATION_DIVISION_BY_ZERO (0 by the power of a negative
+ * exponent), or CALCULATION_OVERFLOW.
  */
-int calculatePowerForInts(const int base, const int exponent)
+CalculationStatus calculatePowerForInts(const CalcInt base, CalcInt exponent, CalcInt *result)
 {
-	int result = base;
-
-	if(exponent == 0)
+	if(exponent < 0)
 	{
-		return INTEGER_TO_THE_POWER_OF_ZERO;
+		if(base == 0)
+		{
+			return CALCULATION_DIVISION_BY_ZERO;
+		}
+		//1 / b ^ -a is 0, unless b is 1 or -1.
+		if(base == 1 || base == -1)
+		{
+			*result = (base == -1 && (exponent & ODD_MASK)) ? -1 : 1;
+		}
+		else
+		{
+			*result = 0;
+		}
+		return CALCULATION_SUCCESS;
 	}
 
-	int i;
+	CalcInt power = INTEGER_TO_THE_POWER_OF_ZERO;
+	CalcInt square = base;
 
-	for(i = 1 ; i < exponent ; i++)
+	while(exponent > 0)
 	{
-		result *= base;
+		if((exponent & ODD_MASK) && __builtin_mul_overflow(power, square, &power))
+		{
+			return CALCULATION_OVERFLOW;
+		}
+		exponent >>= 1;
+		//if the square overflows and it's needed, the power overflows as well.
+		if(exponent > 0 && __builtin_mul_overflow(square, square, &square))
+		{
+			return CALCULATION_OVERFLOW;
+		}
 	}
 
-	return result;
+	*result = power;
+	return CALCULATION_SUCCESS;
 }
 
 /**
- * This function calculates integer b (given binary operator) integer a. For example: b / a, if
- * the given operator is '/' (division operator).
+ * This function calculates integer b (given operation) integer a. For example: b / a, if the
+ * given operation is DIVIDE.
  * @param firstNum - first integer.
  * @param secondNum - second integer.
- * @param operation - a char represents a binary operation ('^' or '*' or '/' or '+' or '-').
- * @return b operation a.
+ * @param opCode - the operation (the OpCode of '^' or '*' or '/' or '+' or '-').
+ * @param result - output: b operation a.
+ * @return CALCULATION_SUCCESS, CALCULATION_DIVISION_BY_ZERO, or CALCULATION_OVERFLOW.
  */
-int calculateBinaryOperation(const int firstNum, const int secondNum, const char operation)
-
+CalculationStatus calculateBinaryOperation(const CalcInt firstNum, const CalcInt secondNum,
+										   const char opCode, CalcInt *result)
 {
+	int isOverflow;
 
-	if(operation == POWER_CHAR)
-	{
-		return calculatePowerForInts(firstNum, secondNum);
-	}
-	else if(operation == MULTIPLY_CHAR)
-	{
-		return firstNum * secondNum;
-	}
-	else if(operation == DIVIDE_CHAR)
+	switch(opCode)
 	{
-		return firstNum / secondNum;
-	}
-	else if(operation == PLUS_CHAR)
-	{
-		return firstNum + secondNum;
+		case POWER:
+			return calculatePowerForInts(firstNum, secondNum, result);
+		case MULTIPLY:
+			isOverflow = __builtin_mul_overflow(firstNum, secondNum, result);
+			break;
+		case DIVIDE:
+			if(secondNum == 0)
+			{
+				return CALCULATION_DIVISION_BY_ZERO;
+			}
+			//the only quotient which overflows.
+			isOverflow = (secondNum == -1 && firstNum == -CALC_INT_MAX - 1);
+			if(!isOverflow)
+			{
+				*result = firstNum / secondNum;
+			}
+			break;
+		case ADD:
+			isOverflow = __builtin_add_overflow(firstNum, secondNum, result);
+			break;
+		default:
+			isOverflow = __builtin_sub_overflow(firstNum, secondNum, result);
+			break;
 	}
 
-	return firstNum - secondNum;
+	return isOverflow ? CALCULATION_OVERFLOW : CALCULATION_SUCCESS;
 }
 
 /**
- * This function adds a given char to an arithmetic expression (infix or postfix).
+ * This function returns the error message of a calculation which didn't succeed.
+ * @param status - the result of the calculation.
+ * @return the error message.
+ */
+const char *calculationErrorMessage(const CalculationStatus status)
+{
+	return (status == CALCULATION_DIVISION_BY_ZERO) ? DIVISION_BY_ZERO : OVERFLOW;
+}
+
+/**
+ * This function adds a given operator or parenthesis char to an arithmetic expression (infix or
+ * postfix).
  * @param sizeOfExpression - the expression's size.
  * @param expression - the expression we add a char to.
  * @param c - the char to add to the expression.
  * @return the new size of the expression.
  */
-int addCharToExpression(int sizeOfExpression, char *expression[MAX_SIZE_OF_EXPRESSION],
-						const char c)
+int addCharToExpression(int sizeOfExpression, Token *expression, const char c)
 {
-	expression[sizeOfExpression] = NULL;
+	Token *token = &expression[sizeOfExpression];
 
-	expression[sizeOfExpression] = (char*) calloc(sizeof(char) + 1, sizeof(char));
-
-	nullPointerCheckerForAllocatedMemory(expression[sizeOfExpression]);
-
-	expression[sizeOfExpression][FIRST_CHAR_INDEX] = c;
-
-	expression[sizeOfExpression][SECOND_CHAR_INDEX] = EMPTY_CHAR;
+	token->kind = isOperatorChar(c) ? OPERATOR_TOKEN : PARENTHESIS_TOKEN;
+	token->operation = c;
+	token->isTooBig = FALSE;
+	token->value = DUMMY_VALUE;
+	token->start = DUMMY_VALUE;
+	token->length = DUMMY_VALUE;
 
 	sizeOfExpression++;
 
@@ -203,8 +417,8 @@ int addCharToExpression(int sizeOfExpression, char *expression[MAX_SIZE_OF_EXPRE
  * @param expression - the input expression we need to parse.
  * @return the new size of the infix expression.
  */
-int calculateInfixExpression(char *infixExpression[MAX_SIZE_OF_EXPRESSION],
-							 const size_t sizeOfExpression, char *expression)
+int calculateInfixExpression(Token *infixExpression, const size_t sizeOfExpression,
+							 const char *expression)
 {
 	size_t j = 0;
 	int countDigits = 0;
@@ -213,29 +427,26 @@ int calculateInfixExpression(char *infixExpression[MAX_SIZE_OF_EXPRESSION],
 
 	for(j = 0 ; j < sizeOfExpression ; j++)
 	{
-		if(isdigit(expression[j]))
+		if(isdigit((unsigned char) expression[j]))
 		{
 			countDigits = 1;
 			startOfNumber = j;
 
-			while(isdigit(expression[j + 1]))
+			while(isdigit((unsigned char) expression[j + 1]))
 			{
 				countDigits++;
 				j++;
 			}
 
-			infixExpression[sizeOfInfix] = NULL;
-			infixExpression[sizeOfInfix] = (char*) calloc((size_t)countDigits + 1, sizeof(char));
-			nullPointerCheckerForAllocatedMemory(infixExpression[sizeOfInfix]);
-
-			size_t i;
-
-			for(i = startOfNumber ; i < startOfNumber + countDigits ; i++)
-			{
-				infixExpression[sizeOfInfix][i - startOfNumber] = expression[i];
-			}
-
-			infixExpression[sizeOfInfix][countDigits] = EMPTY_CHAR;
+			Token *token = &infixExpression[sizeOfInfix];
+			token->kind = NUMBER_TOKEN;
+			token->operation = EMPTY_CHAR;
+			errno = 0;
+			long long value = strtoll(expression + startOfNumber, NULL, BASE_OF_COUNTING);
+			token->isTooBig = (errno == ERANGE || value > CALC_INT_MAX);
+			token->value = token->isTooBig ? DUMMY_VALUE : (CalcInt) value;
+			token->start = startOfNumber;
+			token->length = countDigits;
 
 			sizeOfInfix++;
 
@@ -251,11 +462,43 @@ int calculateInfixExpression(char *infixExpression[MAX_SIZE_OF_EXPRESSION],
 }
 
 /**
- * This function prints an expression (infix or postfix).
+ * This function calculates the length of the text of an expression (infix or postfix), as it is
+ * printed.
+ * @param sizeOfExpression - the expression's size.
+ * @param expression - the expression.
+ * @return the length of the text.
+ */
+size_t calculateLengthOfExpressionText(const int sizeOfExpression, const Token *expression)
+{
+	size_t lengthOfText = 0;
+
+	int i;
+
+	for(i = 0 ; i < sizeOfExpression ; i++)
+	{
+		if(expression[i].kind == NUMBER_TOKEN)
+		{
+			lengthOfText += (size_t) expression[i].length + NUMBER_PRINT_EXTRA_LENGTH;
+		}
+		else
+		{
+			lengthOfText++;
+		}
+	}
+
+	return lengthOfText;
+}
+
+/**
+ * This function writes the text of an expression (infix or postfix), as it is printed.
  * @param sizeOfExpression - the expression's size.
  * @param expression - the expression we have to print.
+ * @param source - the input expression, of the spans of the numbers.
+ * @param text - the text, which has room for it.
+ * @return the end of the text.
  */
-void printExpression(const int sizeOfExpression, char **expression)
+char *writeExpressionText(const int sizeOfExpression, const Token *expression,
+						  const char *source, char *text)
 {
 
 	int i;
@@ -264,33 +507,38 @@ void printExpression(const int sizeOfExpression, char **expression)
 	{
 
 		//if it is a number - print spaces before and after. Else: print without spaces.
-		if(isdigit(expression[i][FIRST_CHAR_INDEX]))
+		if(expression[i].kind == NUMBER_TOKEN)
 		{
-			printf(NUMBER_PRINT_PATTERN, expression[i]);
+			text += sprintf(text, NUMBER_TOKEN_PRINT_PATTERN, expression[i].length,
+							source + expression[i].start);
 		}
 		else
 		{
-			printf(OPERATOR_AND_PARENTHESIS_PRINT_PATTERN, expression[i]);
+			*text = expression[i].operation;
+			text++;
 		}
 
 	}
 
-	printf(NEW_LINE);
+	*text = EMPTY_CHAR;
+	text++;
+
+	return text;
 }
 
 /**
- * This function updates the temp data (which is the data of the top node of the char stack),
+ * This function updates the temp data (which is the data of the top element of the char stack),
  * if and only if the stack is not empty.
  * @param charStack - the stack we are using while converting infix to postfix expression.
- * @param tempData - the data of the top node of the char stack we are using in our algorithm.
+ * @param tempData - the data of the top element of the char stack we are using in our algorithm.
  * @return the new value of the temp data.
  */
-char *updateData(Stack *charStack, char *tempData)
+char updateData(const CharStack *charStack, char tempData)
 {
 
-	if(!(isEmptyStack(charStack)))
+	if(!(CharStackIsEmpty(charStack)))
 	{
-		tempData = (char*) charStack->_top->_data;
+		tempData = CharStackPeek(charStack);
 	}
 
 	return tempData;
@@ -303,29 +551,24 @@ char *updateData(Stack *charStack, char *tempData)
  * @param postfixExpression - the postfix expression we covert to.
  * @param charStack - the stack we are using for the conversion algorithm.
  * @param sizeOfPostfix - the postfix expression's size.
- * @param tempData - the first popped data from the stack.
+ * @param tempData - the data of the top element of the stack.
  * @param index - the index of the iteration we are in right now in our algorithm.
  */
-int handleOperatorChar(char *infixExpression[MAX_SIZE_OF_EXPRESSION],
-					   char *postfixExpression[MAX_SIZE_OF_EXPRESSION], Stack *charStack,
-					   int sizeOfPostfix, char *tempData, int index)
+int handleOperatorChar(const Token *infixExpression, Token *postfixExpression,
+					   CharStack *charStack, int sizeOfPostfix, char tempData, int index)
 {
-	while(!(isEmptyStack(charStack)) && tempData[FIRST_CHAR_INDEX] != LEFT_PARENTHESIS_CHAR &&
-		  compareOperators(infixExpression[index][FIRST_CHAR_INDEX], tempData[FIRST_CHAR_INDEX]))
+	while(!(CharStackIsEmpty(charStack)) && tempData != LEFT_PARENTHESIS_CHAR &&
+		  compareOperators(infixExpression[index].operation, tempData))
 	{
 
-		char tempHeadData;
-		pop(charStack, &tempHeadData);
+		char tempHeadData = CharStackPop(charStack);
 
 		sizeOfPostfix = addCharToExpression(sizeOfPostfix, postfixExpression, tempHeadData);
 
-		if(!(isEmptyStack(charStack)))
-		{
-			tempData = (char*) charStack->_top->_data;
-		}
+		tempData = updateData(charStack, tempData);
 
 	}
-	push(charStack, &infixExpression[index][FIRST_CHAR_INDEX]);
+	checkPush(CharStackPush(charStack, infixExpression[index].operation));
 
 	return sizeOfPostfix;
 }
@@ -335,14 +578,13 @@ int handleOperatorChar(char *infixExpression[MAX_SIZE_OF_EXPRESSION],
  * @param sizeOfInfix - infix expression's size.
  * @param infixExpression - the infix expression.
  * @param postfixExpression - the postfix expression we need to adjust.
+ * @param charStack - the stack of the conversion, which is empty.
  * @return the new size of the new postfix expression.
  */
 int calculatePostfixExpression(const int sizeOfInfix,
-							   char *infixExpression[MAX_SIZE_OF_EXPRESSION],
-							   char *postfixExpression[MAX_SIZE_OF_EXPRESSION])
+							   const Token *infixExpression, Token *postfixExpression,
+							   CharStack *charStack)
 {
-	Stack *charStack = stackAlloc(sizeof(char));
-
 	int sizeOfPostfix = 0;
 
 	int i;
@@ -350,55 +592,46 @@ int calculatePostfixExpression(const int sizeOfInfix,
 	for(i = 0 ; i < sizeOfInfix ; i++)
 	{
 
-		if(isdigit(infixExpression[i][FIRST_CHAR_INDEX]))
+		if(infixExpression[i].kind == NUMBER_TOKEN)
 		{
-			size_t tempLenOfNum = strlen(infixExpression[i]);
-
-			postfixExpression[sizeOfPostfix] = NULL;
-			postfixExpression[sizeOfPostfix] = (char*) calloc(tempLenOfNum + 1, sizeof(char));
-			nullPointerCheckerForAllocatedMemory(postfixExpression[sizeOfPostfix]);
-
-			strcpy(postfixExpression[sizeOfPostfix], infixExpression[i]);
-			postfixExpression[sizeOfPostfix][tempLenOfNum] = EMPTY_CHAR;
+			postfixExpression[sizeOfPostfix] = infixExpression[i];
 			sizeOfPostfix++;
 		}
 
-		if(infixExpression[i][FIRST_CHAR_INDEX] == LEFT_PARENTHESIS_CHAR)
+		if(infixExpression[i].operation == LEFT_PARENTHESIS_CHAR)
 		{
-			push(charStack, &infixExpression[i][FIRST_CHAR_INDEX]);
+			checkPush(CharStackPush(charStack, infixExpression[i].operation));
 		}
 
-		if(infixExpression[i][FIRST_CHAR_INDEX] == RIGHT_PARENTHESIS_CHAR)
+		if(infixExpression[i].operation == RIGHT_PARENTHESIS_CHAR)
 		{
-			char *tempData = (char*) charStack->_top->_data;
-			while(!(isEmptyStack(charStack)) &&
-				  tempData[FIRST_CHAR_INDEX] != LEFT_PARENTHESIS_CHAR)
+			char tempData = updateData(charStack, EMPTY_CHAR);
+			while(!(CharStackIsEmpty(charStack)) && tempData != LEFT_PARENTHESIS_CHAR)
 			{
-				char tempHeadData;
-				pop(charStack, &tempHeadData);
+				char tempHeadData = CharStackPop(charStack);
 
 				sizeOfPostfix = addCharToExpression(sizeOfPostfix, postfixExpression,
 													tempHeadData);
 
 				tempData = updateData(charStack, tempData);
 			}
-			char discardLeftParenthesis;
-			pop(charStack, &discardLeftParenthesis);
+			//discard the left parenthesis.
+			CharStackPop(charStack);
 		}
 
-		if(isOperatorChar(infixExpression[i][FIRST_CHAR_INDEX]))
+		if(infixExpression[i].kind == OPERATOR_TOKEN)
 		{
-			if(isEmptyStack(charStack))
+			if(CharStackIsEmpty(charStack))
 			{
-				push(charStack, &infixExpression[i][FIRST_CHAR_INDEX]);
+				checkPush(CharStackPush(charStack, infixExpression[i].operation));
 			}
 			else
 			{
-				char *tempData = (char*) charStack->_top->_data;
+				char tempData = CharStackPeek(charStack);
 
-				if(tempData[FIRST_CHAR_INDEX] == LEFT_PARENTHESIS_CHAR)
+				if(tempData == LEFT_PARENTHESIS_CHAR)
 				{
-					push(charStack, &infixExpression[i][FIRST_CHAR_INDEX]);
+					checkPush(CharStackPush(charStack, infixExpression[i].operation));
 					continue;
 				}
 
@@ -408,154 +641,1054 @@ int calculatePostfixExpression(const int sizeOfInfix,
 		}
 	}
 
-	while(!(isEmptyStack(charStack)))
+	while(!(CharStackIsEmpty(charStack)))
 	{
-		char tempHeadData;
-		pop(charStack, &tempHeadData);
+		char tempHeadData = CharStackPop(charStack);
 
 		sizeOfPostfix = addCharToExpression(sizeOfPostfix, postfixExpression, tempHeadData);
 	}
 
-	freeStack(&charStack);
-
 	return sizeOfPostfix;
 }
 
 /**
- * This function calculates the result of the given postfix expression.
- * @param sizeOfPostfix - the postfix expression's size.
- * @param postfixExpression - the postfix expression we have to calulate its value.
+ * This function returns the operation of a binary operator char.
+ * @param operation - a char represents a binary operation ('^' or '*' or '/' or '+' or '-').
+ * @return the operation.
  */
-void calculateResultAndPrintIt(const int sizeOfPostfix,
-							   char *postfixExpression[MAX_SIZE_OF_EXPRESSION])
+OpCode operatorToOpCode(const char operation)
 {
-	int result = 0;
+	if(operation == POWER_CHAR)
+	{
+		return POWER;
+	}
+	else if(operation == MULTIPLY_CHAR)
+	{
+		return MULTIPLY;
+	}
+	else if(operation == DIVIDE_CHAR)
+	{
+		return DIVIDE;
+	}
+	else if(operation == PLUS_CHAR)
+	{
+		return ADD;
+	}
 
-	Stack *intStack = stackAlloc(sizeof(int));
+	return SUBTRACT;
+}
 
-	int i;
+/**
+ * This function compiles the postfix expression into instructions: its parentheses (which may be
+ * left in it if they aren't balanced) are skipped.
+ * @param sizeOfPostfix - the postfix expression's size.
+ * @param postfixExpression - the postfix expression we compile.
+ * @param code - the instructions, at least sizeOfPostfix of them.
+ * @return the number of instructions.
+ */
+int compilePostfixExpression(const int sizeOfPostfix, const Token *postfixExpression,
+							 Instruction *code)
+{
+	int sizeOfCode = 0;
 
-	int divisionByZero = FALSE;
+	int i;
 
 	for(i = 0 ; i < sizeOfPostfix ; i++)
 	{
 
-		if(isdigit(postfixExpression[i][FIRST_CHAR_INDEX]))
+		if(postfixExpression[i].kind == NUMBER_TOKEN)
 		{
-			int tempInt = (int) strtol(postfixExpression[i], NULL, BASE_OF_COUNTING);
-			push(intStack, &tempInt);
+			code[sizeOfCode].opCode = postfixExpression[i].isTooBig ? PUSH_TOO_BIG_NUMBER :
+									  PUSH_NUMBER;
+			code[sizeOfCode].number = postfixExpression[i].value;
+			sizeOfCode++;
 		}
 
-		if(isOperatorChar(postfixExpression[i][FIRST_CHAR_INDEX]))
+		if(postfixExpression[i].kind == OPERATOR_TOKEN)
 		{
-			int a;
-			pop(intStack, &a);
+			code[sizeOfCode].opCode = (char) operatorToOpCode(postfixExpression[i].operation);
+			code[sizeOfCode].number = DUMMY_VALUE;
+			sizeOfCode++;
+		}
+	}
+
+	return sizeOfCode;
+}
+
+/**
+ * This function makes room for the tokens of an expression in the workspace: an expression has at
+ * most a token for every char of it. The tokens grow geometrically.
+ * @param workspace - the workspace of the compilation.
+ * @param sizeOfExpression - the size of the expression.
+ */
+void reserveWorkspaceForExpression(CompileWorkspace *workspace, const size_t sizeOfExpression)
+{
+	if(sizeOfExpression <= workspace->maxNumOfTokens)
+	{
+		return;
+	}
+
+	size_t maxNumOfTokens = (workspace->maxNumOfTokens > 0) ? workspace->maxNumOfTokens :
+							INITIAL_NUM_OF_TOKENS;
+	while(maxNumOfTokens < sizeOfExpression)
+	{
+		maxNumOfTokens *= CACHE_GROWTH_FACTOR;
+	}
+
+	//the old tokens aren't needed, so there's nothing to copy.
+	free(workspace->infixExpression);
+	free(workspace->postfixExpression);
+	workspace->infixExpression = (Token*) malloc(maxNumOfTokens * sizeof(Token));
+	nullPointerCheckerForAllocatedMemory(workspace->infixExpression);
+	workspace->postfixExpression = (Token*) malloc(maxNumOfTokens * sizeof(Token));
+	nullPointerCheckerForAllocatedMemory(workspace->postfixExpression);
+	workspace->maxNumOfTokens = maxNumOfTokens;
+}
+
+/**
+ * This function initializes a workspace of compiling expressions.
+ * @param workspace - the workspace.
+ */
+void initCompileWorkspace(CompileWorkspace *workspace)
+{
+	workspace->infixExpression = NULL;
+	workspace->postfixExpression = NULL;
+	workspace->maxNumOfTokens = 0;
+	CharStackInit(&workspace->charStack);
+}
+
+/**
+ * This function frees a workspace of compiling expressions.
+ * @param workspace - the workspace.
+ */
+void freeCompileWorkspace(CompileWorkspace *workspace)
+{
+	free(workspace->infixExpression);
+	free(workspace->postfixExpression);
+	CharStackFree(&workspace->charStack);
+	initCompileWorkspace(workspace);
+}
+
+/**
+ * This function compiles an input expression: it calculates its infix form, and then its postfix
+ * form, and keeps their texts and the instructions of the postfix form.
+ * @param workspace - the workspace of the compilation.
+ * @param expression - the input expression.
+ * @param compiled - the compiled expression.
+ */
+void compileExpression(CompileWorkspace *workspace, const char *expression,
+					   CompiledExpression *compiled)
+{
+	//get size of the input expression.
+	size_t sizeOfExpression = strlen(expression);
+	reserveWorkspaceForExpression(workspace, sizeOfExpression);
+
+	//calculate infix expression.
+	Token *infixExpression = workspace->infixExpression;
+	int sizeOfInfix = calculateInfixExpression(infixExpression, sizeOfExpression, expression);
+
+	//calculate postfix expression.
+	Token *postfixExpression = workspace->postfixExpression;
+	int sizeOfPostfix = calculatePostfixExpression(sizeOfInfix, infixExpression,
+												   postfixExpression, &workspace->charStack);
+
+	//allocate the instructions and the texts of the infix and postfix expressions together.
+	size_t sizeOfCode = ((size_t) sizeOfPostfix + 1) * sizeof(Instruction);
+	size_t lengthOfInfixText = calculateLengthOfExpressionText(sizeOfInfix, infixExpression);
+	size_t lengthOfPostfixText = calculateLengthOfExpressionText(sizeOfPostfix,
+																 postfixExpression);
+	char *block = (char*) malloc(sizeOfCode + lengthOfInfixText + lengthOfPostfixText + 2);
+	nullPointerCheckerForAllocatedMemory(block);
+
+	compiled->code = (Instruction*) block;
+	compiled->sizeOfCode = compilePostfixExpression(sizeOfPostfix, postfixExpression,
+													compiled->code);
+	compiled->infixText = block + sizeOfCode;
+	compiled->postfixText = writeExpressionText(sizeOfInfix, infixExpression, expression,
+												compiled->infixText);
+	writeExpressionText(sizeOfPostfix, postfixExpression, expression, compiled->postfixText);
+}
 
-			int b;
-			pop(intStack, &b);
+/**
+ * This function frees a compiled expression.
+ * @param compiled - the compiled expression.
+ */
+void freeCompiledExpression(CompiledExpression *compiled)
+{
+	free(compiled->code);
+}
+
+/**
+ * This function calculates the result of a compiled expression.
+ * @param compiled - the compiled expression.
+ * @param intStack - the stack of the calculation, which is empty.
+ * @param result - output: the result.
+ * @return CALCULATION_SUCCESS, or the error of the first operation which failed (a division by 0
+ * or an overflow, of an operation or of a number which is too big).
+ */
+CalculationStatus calculateResult(const CompiledExpression *compiled, IntStack *intStack,
+								  CalcInt *result)
+{
+	int i;
+
+	CalculationStatus status = CALCULATION_SUCCESS;
+
+	for(i = 0 ; i < compiled->sizeOfCode ; i++)
+	{
+		const Instruction *instruction = &compiled->code[i];
+
+		if(instruction->opCode == PUSH_NUMBER)
+		{
+			checkPush(IntStackPush(intStack, instruction->number));
+		}
+		else if(instruction->opCode == PUSH_TOO_BIG_NUMBER)
+		{
+			status = CALCULATION_OVERFLOW;
+			break;
+		}
+		else
+		{
+			CalcInt a = IntStackPop(intStack);
 
-			if(a == 0 && postfixExpression[i][FIRST_CHAR_INDEX] == DIVIDE_CHAR)
+			CalcInt b = IntStackPop(intStack);
+
+			CalcInt tempResult;
+
+			status = calculateBinaryOperation(b, a, instruction->opCode, &tempResult);
+
+			if(status != CALCULATION_SUCCESS)
 			{
-				divisionByZero = TRUE;
 				break;
 			}
-			else
-			{
-				int tempResult;
-
-				tempResult = calculateBinaryOperation(b, a, postfixExpression[i][FIRST_CHAR_INDEX]);
 
-				push(intStack, &tempResult);
-			}
+			checkPush(IntStackPush(intStack, tempResult));
 		}
 	}
 
-	if(!(isEmptyStack(intStack)))
+	if(!(IntStackIsEmpty(intStack)))
 	{
-		pop(intStack, &result);
+		*result = IntStackPop(intStack);
 	}
 	else
 	{
-		result = DUMMY_VALUE;
+		*result = DUMMY_VALUE;
 	}
 
-	if(divisionByZero)
+	IntStackClear(intStack);
+
+	return status;
+}
+
+/**
+ * This function calculates the hash of an input expression (FNV-1a).
+ * @param expression - the input expression.
+ * @return the hash.
+ */
+size_t hashExpression(const char *expression)
+{
+	unsigned int hash = FNV_OFFSET_BASIS;
+
+	for( ; *expression != EMPTY_CHAR ; expression++)
 	{
-		fprintf(stderr, DIVISION_BY_ZERO);
-		exit(EXIT_FAILURE);
+		hash = (hash ^ (unsigned char) *expression) * FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/**
+ * This function finds the entry of an input expression in the cache: its own entry, or the empty
+ * entry where it belongs.
+ * @param entries - the entries of the cache.
+ * @param capacity - the number of entries, a power of 2.
+ * @param expression - the input expression.
+ * @return the entry.
+ */
+CacheEntry *findCacheEntry(CacheEntry *entries, const size_t capacity, const char *expression)
+{
+	size_t i = hashExpression(expression) & (capacity - 1);
+
+	while(entries[i].expression != NULL && strcmp(entries[i].expression, expression) != 0)
+	{
+		i = (i + 1) & (capacity - 1);
+	}
+
+	return &entries[i];
+}
+
+/**
+ * This function doubles the capacity of the cache.
+ * @param cache - the cache.
+ */
+void growExpressionCache(ExpressionCache *cache)
+{
+	size_t capacity = (cache->capacity > 0) ? cache->capacity * CACHE_GROWTH_FACTOR :
+					  INITIAL_CACHE_CAPACITY;
+	CacheEntry *entries = (CacheEntry*) calloc(capacity, sizeof(CacheEntry));
+	nullPointerCheckerForAllocatedMemory(entries);
+
+	size_t i;
+
+	for(i = 0 ; i < cache->capacity ; i++)
+	{
+		if(cache->entries[i].expression != NULL)
+		{
+			*findCacheEntry(entries, capacity, cache->entries[i].expression) = cache->entries[i];
+		}
+	}
+
+	free(cache->entries);
+	cache->entries = entries;
+	cache->capacity = capacity;
+}
+
+/**
+ * This function returns the compiled form of an input expression: from the cache, or it compiles
+ * the expression and adds it to the cache. When the cache is full (MAX_CACHED_EXPRESSIONS), or the
+ * expression is longer than MAX_CACHED_EXPRESSION_LENGTH (so it isn't worth keeping), the
+ * expression is compiled to uncached, and the caller frees it.
+ * @param cache - the cache.
+ * @param workspace - the workspace of the compilation.
+ * @param expression - the input expression.
+ * @param uncached - the compiled expression, if it isn't cached.
+ * @return the compiled expression.
+ */
+const CompiledExpression *getCompiledExpression(ExpressionCache *cache,
+												CompileWorkspace *workspace,
+												const char *expression,
+												CompiledExpression *uncached)
+{
+	size_t sizeOfExpression = strlen(expression);
+
+	if(sizeOfExpression > MAX_CACHED_EXPRESSION_LENGTH)
+	{
+		compileExpression(workspace, expression, uncached);
+		return uncached;
+	}
+
+	if(cache->capacity > 0)
+	{
+		CacheEntry *entry = findCacheEntry(cache->entries, cache->capacity, expression);
+		if(entry->expression != NULL)
+		{
+			return &entry->compiled;
+		}
+	}
+
+	if(cache->size >= MAX_CACHED_EXPRESSIONS)
+	{
+		compileExpression(workspace, expression, uncached);
+		return uncached;
+	}
+
+	//keep the load of the table under a half.
+	if((cache->size + 1) * CACHE_GROWTH_FACTOR > cache->capacity)
+	{
+		growExpressionCache(cache);
+	}
+
+	CacheEntry *entry = findCacheEntry(cache->entries, cache->capacity, expression);
+	entry->expression = (char*) malloc(sizeOfExpression + 1);
+	nullPointerCheckerForAllocatedMemory(entry->expression);
+	strcpy(entry->expression, expression);
+	compileExpression(workspace, expression, &entry->compiled);
+	cache->size++;
+
+	return &entry->compiled;
+}
+
+/**
+ * This function frees the cache and all of its compiled expressions.
+ * @param cache - the cache.
+ */
+void freeExpressionCache(ExpressionCache *cache)
+{
+	size_t i;
+
+	for(i = 0 ; i < cache->capacity ; i++)
+	{
+		if(cache->entries[i].expression != NULL)
+		{
+			free(cache->entries[i].expression);
+			freeCompiledExpression(&cache->entries[i].compiled);
+		}
+	}
+
+	free(cache->entries);
+	cache->entries = NULL;
+	cache->capacity = 0;
+	cache->size = 0;
+}
+
+/**
+ * This struct represents an output buffer of the batch mode, which is written to stdout in big
+ * blocks.
+ */
+typedef struct OutputBuffer
+{
+	char *bytes;
+	size_t size;
+	size_t capacity;
+} OutputBuffer;
+
+/**
+ * These are the states of a chunk of the batch mode: free, read and ready for a worker, or
+ * calculated and ready to be written.
+ */
+typedef enum ChunkState
+{
+	CHUNK_FREE,
+	CHUNK_READY,
+	CHUNK_DONE
+} ChunkState;
+
+/**
+ * This struct represents a chunk of the input of the batch mode: whole lines (the last line of the
+ * input may have no new line char), and the output of their results. The text has room for
+ * capacity chars and a null char, and grows for a line longer than a chunk.
+ */
+typedef struct BatchChunk
+{
+	char *text;
+	size_t size;
+	size_t capacity;
+	long firstLineNumber;
+	OutputBuffer output;
+	ChunkState state;
+} BatchChunk;
+
+/**
+ * This struct represents the reader of the input of the batch mode, which splits it to chunks.
+ */
+typedef struct BatchReader
+{
+	char *carry;
+	size_t carrySize;
+	size_t carryCapacity;
+	long nextLineNumber;
+	int isEndOfInput;
+} BatchReader;
+
+/**
+ * This struct represents a worker of the batch mode, which calculates chunks with its own cache,
+ * workspace and stack.
+ */
+typedef struct BatchWorker
+{
+	ExpressionCache cache;
+	CompileWorkspace workspace;
+	IntStack intStack;
+	struct BatchPipeline *pipeline;
+	pthread_t thread;
+} BatchWorker;
+
+/**
+ * This struct represents the pipeline of the batch mode with worker threads: the main thread
+ * reads chunks into a ring of chunks, the workers calculate them in any order, and the main thread
+ * writes their outputs in the order of the input (the ring is the reorder buffer).
+ */
+typedef struct BatchPipeline
+{
+	BatchChunk *chunks;
+	int numOfChunks;
+	long numOfReadChunks;
+	long numOfTakenChunks;
+	int isEndOfInput;
+	int resultsOnly;
+	pthread_mutex_t mutex;
+	pthread_cond_t chunkReady;
+	pthread_cond_t chunkDone;
+} BatchPipeline;
+
+/**
+ * This function writes an output buffer to stdout, and empties it.
+ * @param output - the output buffer.
+ */
+void flushOutput(OutputBuffer *output)
+{
+	if(output->size > 0)
+	{
+		fwrite(output->bytes, sizeof(char), output->size, stdout);
+		output->size = 0;
+	}
+}
+
+/**
+ * This function appends formatted text to an output buffer (like printf).
+ * @param output - the output buffer.
+ * @param format - the format of the text.
+ */
+void appendToOutput(OutputBuffer *output, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(output->bytes + output->size, output->capacity - output->size, format,
+						args);
+	va_end(args);
+
+	//if the text didn't fit, grow the buffer and format it again.
+	if(output->size + (size_t) len + 1 > output->capacity)
+	{
+		size_t capacity = output->capacity;
+		while(output->size + (size_t) len + 1 > capacity)
+		{
+			capacity *= CACHE_GROWTH_FACTOR;
+		}
+		output->bytes = (char*) realloc(output->bytes, capacity);
+		nullPointerCheckerForAllocatedMemory(output->bytes);
+		output->capacity = capacity;
+
+		va_start(args, format);
+		vsnprintf(output->bytes + output->size, (size_t) len + 1, format, args);
+		va_end(args);
+	}
+
+	output->size += (size_t) len;
+}
+
+/**
+ * This function returns the time of a monotonic clock, in seconds.
+ * @return the time.
+ */
+double currentSeconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + (double) now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * This function calculates an expression (a line of the input) of the batch mode, and appends its
+ * results to the output. Errors are reported in the output line of the result, with the number of
+ * the line, and the batch goes on.
+ * @param worker - the worker.
+ * @param line - the line, without its new line char.
+ * @param lineNumber - the number of the line.
+ * @param resultsOnly - TRUE to print only the result (or the error) of the expression.
+ * @param output - the output buffer.
+ */
+void calculateBatchLine(BatchWorker *worker, const char *line, const long lineNumber,
+						const int resultsOnly, OutputBuffer *output)
+{
+	CompiledExpression uncached = {NULL, NULL, NULL, 0};
+	const CompiledExpression *compiled = getCompiledExpression(&worker->cache, &worker->workspace,
+															   line, &uncached);
+
+	if(!resultsOnly)
+	{
+		appendToOutput(output, PRINT_INFIX_AND_POSTFIX, compiled->infixText,
+					   compiled->postfixText);
+	}
+
+	CalcInt result;
+	CalculationStatus status = calculateResult(compiled, &worker->intStack, &result);
+	if(status == CALCULATION_SUCCESS)
+	{
+		appendToOutput(output, resultsOnly ? PRINT_RESULT_ONLY : PRINT_RESULT, result);
 	}
 	else
 	{
-		printf(PRINT_RESULT, result);
+		appendToOutput(output, PRINT_LINE_ERROR, lineNumber, calculationErrorMessage(status));
 	}
 
-	freeStack(&intStack);
+	freeCompiledExpression(&uncached);
 }
 
 /**
- * This function frees all the expressions memory allocations we used in our program (for the
- * infix expression and the postfix expression).
- * @param sizeOfPostfix - the postfix expression's size.
- * @param postfixExpression - the postfix expression we calculated in our program.
- * @param sizeOfInfix - the infix expression's size.
- * @param infixExpression - the infix expression we calculated in our program.
+ * This function calculates all the lines of a chunk, to the output of the chunk.
+ * @param worker - the worker.
+ * @param chunk - the chunk.
+ * @param resultsOnly - TRUE to print only the results of the expressions.
+ */
+void calculateBatchChunk(BatchWorker *worker, BatchChunk *chunk, const int resultsOnly)
+{
+	char *line = chunk->text;
+	char *end = chunk->text + chunk->size;
+	long lineNumber = chunk->firstLineNumber;
+
+	while(line < end)
+	{
+		char *newLine = (char*) memchr(line, NEW_LINE_CHAR, (size_t) (end - line));
+		char *endOfLine = (newLine != NULL) ? newLine : end;
+		char *nextLine = (newLine != NULL) ? newLine + 1 : end;
+
+		if(endOfLine > line && endOfLine[-1] == CARRIAGE_RETURN_CHAR)
+		{
+			endOfLine--;
+		}
+		*endOfLine = EMPTY_CHAR;
+		calculateBatchLine(worker, line, lineNumber, resultsOnly, &chunk->output);
+
+		lineNumber++;
+		line = nextLine;
+	}
+}
+
+/**
+ * This function makes room for capacity chars (and a null char) in the text of a chunk, keeping
+ * its first size chars. The text grows geometrically.
+ * @param chunk - the chunk.
+ * @param capacity - the number of chars.
+ * @param size - the number of chars to keep.
+ */
+void reserveChunkText(BatchChunk *chunk, const size_t capacity, const size_t size)
+{
+	if(capacity <= chunk->capacity)
+	{
+		return;
+	}
+
+	size_t newCapacity = (chunk->capacity > 0) ? chunk->capacity : BATCH_CHUNK_SIZE;
+	while(newCapacity < capacity)
+	{
+		newCapacity *= CACHE_GROWTH_FACTOR;
+	}
+
+	char *text = (char*) malloc(newCapacity + 1);
+	nullPointerCheckerForAllocatedMemory(text);
+	if(size > 0)
+	{
+		memcpy(text, chunk->text, size);
+	}
+	free(chunk->text);
+	chunk->text = text;
+	chunk->capacity = newCapacity;
+}
+
+/**
+ * This function reads the next chunk of the input: the beginning of a line which was left from
+ * the previous chunk and then whole lines, as many as fit in the chunk. If a line doesn't fit,
+ * the chunk grows until it does, so a line of any length is calculated as one expression.
+ * @param reader - the reader.
+ * @param chunk - the chunk.
+ * @return TRUE if a chunk was read, FALSE at the end of the input.
+ */
+int readBatchChunk(BatchReader *reader, BatchChunk *chunk)
+{
+	reserveChunkText(chunk, reader->carrySize, 0);
+	if(reader->carrySize > 0)
+	{
+		memcpy(chunk->text, reader->carry, reader->carrySize);
+	}
+	size_t size = reader->carrySize;
+	size_t sizeOfSearched = 0;
+	reader->carrySize = 0;
+
+	//the chunk ends after its last new line char (or at the end of the input).
+	chunk->size = 0;
+	while(TRUE)
+	{
+		if(!reader->isEndOfInput && size < chunk->capacity)
+		{
+			size_t count = fread(chunk->text + size, sizeof(char), chunk->capacity - size, stdin);
+			reader->isEndOfInput = (size + count < chunk->capacity);
+			size += count;
+		}
+
+		size_t i;
+		for(i = size ; i > sizeOfSearched && chunk->size == 0 ; i--)
+		{
+			if(chunk->text[i - 1] == NEW_LINE_CHAR)
+			{
+				chunk->size = i;
+			}
+		}
+		sizeOfSearched = size;
+
+		if(reader->isEndOfInput)
+		{
+			chunk->size = size;
+		}
+		if(chunk->size > 0 || size == 0)
+		{
+			break;
+		}
+
+		reserveChunkText(chunk, chunk->capacity * CACHE_GROWTH_FACTOR, size);
+	}
+
+	if(size == 0)
+	{
+		return FALSE;
+	}
+
+	//keep the beginning of the last line for the next chunk.
+	reader->carrySize = size - chunk->size;
+	if(reader->carrySize > reader->carryCapacity)
+	{
+		free(reader->carry);
+		reader->carry = (char*) malloc(reader->carrySize);
+		nullPointerCheckerForAllocatedMemory(reader->carry);
+		reader->carryCapacity = reader->carrySize;
+	}
+	if(reader->carrySize > 0)
+	{
+		memcpy(reader->carry, chunk->text + chunk->size, reader->carrySize);
+	}
+
+	chunk->firstLineNumber = reader->nextLineNumber;
+	char *line = chunk->text;
+	char *end = chunk->text + chunk->size;
+	while(line < end)
+	{
+		char *newLine = (char*) memchr(line, NEW_LINE_CHAR, (size_t) (end - line));
+		line = (newLine != NULL) ? newLine + 1 : end;
+		reader->nextLineNumber++;
+	}
+
+	return TRUE;
+}
+
+/**
+ * This function allocates the buffers of a chunk.
+ * @param chunk - the chunk.
+ */
+void allocBatchChunk(BatchChunk *chunk)
+{
+	chunk->text = NULL;
+	chunk->capacity = 0;
+	reserveChunkText(chunk, BATCH_CHUNK_SIZE, 0);
+	chunk->size = 0;
+	chunk->output.bytes = (char*) malloc(INITIAL_OUTPUT_CAPACITY);
+	nullPointerCheckerForAllocatedMemory(chunk->output.bytes);
+	chunk->output.size = 0;
+	chunk->output.capacity = INITIAL_OUTPUT_CAPACITY;
+	chunk->state = CHUNK_FREE;
+}
+
+/**
+ * This function frees the buffers of a chunk.
+ * @param chunk - the chunk.
+ */
+void freeBatchChunk(BatchChunk *chunk)
+{
+	free(chunk->text);
+	free(chunk->output.bytes);
+}
+
+/**
+ * This function initializes a worker.
+ * @param worker - the worker.
+ * @param pipeline - the pipeline of the worker, or NULL if the main thread is the worker.
+ */
+void initBatchWorker(BatchWorker *worker, BatchPipeline *pipeline)
+{
+	worker->cache.entries = NULL;
+	worker->cache.capacity = 0;
+	worker->cache.size = 0;
+	initCompileWorkspace(&worker->workspace);
+	IntStackInit(&worker->intStack);
+	worker->pipeline = pipeline;
+}
+
+/**
+ * This function frees the cache, the workspace and the stack of a worker.
+ * @param worker - the worker.
+ */
+void freeBatchWorker(BatchWorker *worker)
+{
+	freeExpressionCache(&worker->cache);
+	freeCompileWorkspace(&worker->workspace);
+	IntStackFree(&worker->intStack);
+}
+
+/**
+ * This function is the work of a worker thread: it takes the next chunk which was read, calculates
+ * it, and marks it done, until the end of the input.
+ * @param arg - the worker.
+ * @return NULL.
+ */
+void *runBatchWorker(void *arg)
+{
+	BatchWorker *worker = (BatchWorker*) arg;
+	BatchPipeline *pipeline = worker->pipeline;
+
+	while(TRUE)
+	{
+		pthread_mutex_lock(&pipeline->mutex);
+		while(pipeline->numOfTakenChunks == pipeline->numOfReadChunks && !pipeline->isEndOfInput)
+		{
+			pthread_cond_wait(&pipeline->chunkReady, &pipeline->mutex);
+		}
+		if(pipeline->numOfTakenChunks == pipeline->numOfReadChunks)
+		{
+			pthread_mutex_unlock(&pipeline->mutex);
+			return NULL;
+		}
+		BatchChunk *chunk = &pipeline->chunks[pipeline->numOfTakenChunks % pipeline->numOfChunks];
+		pipeline->numOfTakenChunks++;
+		pthread_mutex_unlock(&pipeline->mutex);
+
+		calculateBatchChunk(worker, chunk, pipeline->resultsOnly);
+
+		pthread_mutex_lock(&pipeline->mutex);
+		chunk->state = CHUNK_DONE;
+		pthread_cond_broadcast(&pipeline->chunkDone);
+		pthread_mutex_unlock(&pipeline->mutex);
+	}
+}
+
+/**
+ * This function runs the batch mode with worker threads: the main thread reads chunks while there
+ * are free chunks in the ring, and writes the outputs of the chunks in order as they are done.
+ * @param reader - the reader of the input.
+ * @param numOfThreads - the number of worker threads.
+ * @param resultsOnly - TRUE to print only the results of the expressions.
  */
-void freeExpressions(const int sizeOfPostfix, char *postfixExpression[MAX_SIZE_OF_EXPRESSION],
-					 const int sizeOfInfix, char *infixExpression[MAX_SIZE_OF_EXPRESSION])
+void runBatchPipeline(BatchReader *reader, const int numOfThreads, const int resultsOnly)
 {
+	BatchPipeline pipeline;
+	pipeline.numOfChunks = numOfThreads * CHUNKS_PER_THREAD;
+	pipeline.chunks = (BatchChunk*) malloc((size_t) pipeline.numOfChunks * sizeof(BatchChunk));
+	nullPointerCheckerForAllocatedMemory(pipeline.chunks);
+	pipeline.numOfReadChunks = 0;
+	pipeline.numOfTakenChunks = 0;
+	pipeline.isEndOfInput = FALSE;
+	pipeline.resultsOnly = resultsOnly;
+	pthread_mutex_init(&pipeline.mutex, NULL);
+	pthread_cond_init(&pipeline.chunkReady, NULL);
+	pthread_cond_init(&pipeline.chunkDone, NULL);
+
 	int i;
 
-	for(i = 0 ; i < sizeOfPostfix ; i++)
+	for(i = 0 ; i < pipeline.numOfChunks ; i++)
 	{
-		free(postfixExpression[i]);
-		postfixExpression[i] = NULL;
+		allocBatchChunk(&pipeline.chunks[i]);
 	}
 
-	for(i = 0 ; i < sizeOfInfix ; i++)
+	BatchWorker *workers = (BatchWorker*) malloc((size_t) numOfThreads * sizeof(BatchWorker));
+	nullPointerCheckerForAllocatedMemory(workers);
+	for(i = 0 ; i < numOfThreads ; i++)
 	{
-		free(infixExpression[i]);
-		infixExpression[i] = NULL;
+		initBatchWorker(&workers[i], &pipeline);
+		if(pthread_create(&workers[i].thread, NULL, runBatchWorker, &workers[i]) != 0)
+		{
+			fprintf(stderr, THREAD_ERROR);
+			exit(EXIT_FAILURE);
+		}
 	}
+
+	long numOfWrittenChunks = 0;
+	int isEndOfInput = FALSE;
+
+	while(TRUE)
+	{
+		//the chunk after the last one read is free once the chunk a ring before it was written.
+		while(!isEndOfInput && pipeline.numOfReadChunks - numOfWrittenChunks < pipeline.numOfChunks)
+		{
+			BatchChunk *chunk = &pipeline.chunks[pipeline.numOfReadChunks % pipeline.numOfChunks];
+			isEndOfInput = !readBatchChunk(reader, chunk);
+
+			pthread_mutex_lock(&pipeline.mutex);
+			if(isEndOfInput)
+			{
+				pipeline.isEndOfInput = TRUE;
+			}
+			else
+			{
+				chunk->state = CHUNK_READY;
+				pipeline.numOfReadChunks++;
+			}
+			pthread_cond_broadcast(&pipeline.chunkReady);
+			pthread_mutex_unlock(&pipeline.mutex);
+		}
+
+		if(numOfWrittenChunks == pipeline.numOfReadChunks)
+		{
+			break;
+		}
+
+		BatchChunk *chunk = &pipeline.chunks[numOfWrittenChunks % pipeline.numOfChunks];
+		pthread_mutex_lock(&pipeline.mutex);
+		while(chunk->state != CHUNK_DONE)
+		{
+			pthread_cond_wait(&pipeline.chunkDone, &pipeline.mutex);
+		}
+		pthread_mutex_unlock(&pipeline.mutex);
+
+		flushOutput(&chunk->output);
+		chunk->state = CHUNK_FREE;
+		numOfWrittenChunks++;
+	}
+
+	for(i = 0 ; i < numOfThreads ; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+		freeBatchWorker(&workers[i]);
+	}
+	free(workers);
+
+	for(i = 0 ; i < pipeline.numOfChunks ; i++)
+	{
+		freeBatchChunk(&pipeline.chunks[i]);
+	}
+	free(pipeline.chunks);
+	pthread_mutex_destroy(&pipeline.mutex);
+	pthread_cond_destroy(&pipeline.chunkReady);
+	pthread_cond_destroy(&pipeline.chunkDone);
+}
+
+/**
+ * This function is the batch mode of the program: it reads the input in big chunks, calculates
+ * every line of it (an expression which overflows or divides by 0 is an error of its line only),
+ * writes the results through output buffers, and reports the throughput to stderr. With worker
+ * threads, the chunks are calculated in parallel (see runBatchPipeline), and otherwise one after
+ * the other by the main thread.
+ * @param numOfThreads - the number of worker threads, or 0.
+ * @param resultsOnly - TRUE to print only the results of the expressions.
+ */
+void runBatch(const int numOfThreads, const int resultsOnly)
+{
+	BatchReader reader = {NULL, 0, 0, 1, FALSE};
+	double start = currentSeconds();
+
+	if(numOfThreads > 0)
+	{
+		runBatchPipeline(&reader, numOfThreads, resultsOnly);
+	}
+	else
+	{
+		BatchWorker worker;
+		initBatchWorker(&worker, NULL);
+		BatchChunk chunk;
+		allocBatchChunk(&chunk);
+
+		while(readBatchChunk(&reader, &chunk))
+		{
+			calculateBatchChunk(&worker, &chunk, resultsOnly);
+			flushOutput(&chunk.output);
+		}
+
+		freeBatchChunk(&chunk);
+		freeBatchWorker(&worker);
+	}
+
+	fflush(stdout);
+
+	long numOfLines = reader.nextLineNumber - 1;
+	double seconds = currentSeconds() - start;
+	fprintf(stderr, PRINT_BATCH_STATISTICS, numOfLines, seconds,
+			(seconds > 0) ? (double) numOfLines / seconds : 0.0);
+
+	free(reader.carry);
+}
+
+/**
+ * This function parses the number of worker threads of -j.
+ * @param arg - the number.
+ * @return the number of worker threads.
+ */
+int parseNumOfThreads(const char *arg)
+{
+	char *end;
+	long numOfThreads = strtol(arg, &end, BASE_OF_COUNTING);
+	if(*arg == EMPTY_CHAR || *end != EMPTY_CHAR || numOfThreads < 1 ||
+	   numOfThreads > MAX_NUM_OF_THREADS)
+	{
+		fprintf(stderr, ARGS_ERROR);
+		exit(EXIT_FAILURE);
+	}
+	return (int) numOfThreads;
 }
 
 /**
  * This is the main function of the program. It gets an input expression from the user each time,
  * and calculates its infix form. Then, it calculates its postfix form, and eventually calculates
- * its integer value, and prints out all these results.
+ * its integer value, and prints out all these results. An expression is compiled only the first
+ * time it is given, and then it is calculated from the cache. With --batch, it calculates a whole
+ * input file of expressions (see runBatch), with -j <threads> it does it on worker threads, and
+ * with --results-only it prints only their results.
+ * @param argc arguments counter.
+ * @param argv arguments values.
  * @return 0 if succeeded, non-zero otherwise.
  */
-int main()
+int main(int argc, char *argv[])
 {
-	char expression[MAX_SIZE_OF_EXPRESSION] = {EMPTY_CHAR};
+	int batch = FALSE;
+	int resultsOnly = FALSE;
+	int numOfThreads = 0;
+
+	int i;
+
+	for(i = 1 ; i < argc ; i++)
+	{
+		if(strcmp(argv[i], BATCH_OPTION) == 0)
+		{
+			batch = TRUE;
+		}
+		else if(strcmp(argv[i], RESULTS_ONLY_OPTION) == 0)
+		{
+			resultsOnly = TRUE;
+		}
+		else if(strcmp(argv[i], THREADS_OPTION) == 0 && i + 1 < argc)
+		{
+			i++;
+			numOfThreads = parseNumOfThreads(argv[i]);
+			batch = TRUE;
+		}
+		else if(strncmp(argv[i], THREADS_OPTION, strlen(THREADS_OPTION)) == 0)
+		{
+			numOfThreads = parseNumOfThreads(argv[i] + strlen(THREADS_OPTION));
+			batch = TRUE;
+		}
+		else
+		{
+			fprintf(stderr, ARGS_ERROR);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if(resultsOnly && !batch)
+	{
+		fprintf(stderr, ARGS_ERROR);
+		exit(EXIT_FAILURE);
+	}
 
-	while (fgets(expression, MAX_SIZE_OF_EXPRESSION, stdin) != NULL)
+	if(batch)
 	{
-		//get size of the input expression.
-		size_t sizeOfExpression = strlen(expression);
+		runBatch(numOfThreads, resultsOnly);
+		return 0;
+	}
 
-		//calculate infix expression.
-		char *infixExpression[MAX_SIZE_OF_EXPRESSION];
-		int sizeOfInfix = calculateInfixExpression(infixExpression, sizeOfExpression, expression);
+	//the line of the expression grows with getline, so an expression can be of any length.
+	char *expression = NULL;
+	size_t sizeOfLineBuffer = 0;
 
-		//print infix expression.
-		printf("%s", INFIX_TITLE);
-		printExpression(sizeOfInfix, infixExpression);
+	ExpressionCache cache = {NULL, 0, 0};
 
-		//calculate postfix expression.
-		char *postfixExpression[MAX_SIZE_OF_EXPRESSION];
-		int sizeOfPostfix = calculatePostfixExpression(sizeOfInfix, infixExpression,
-													   postfixExpression);
+	CompileWorkspace workspace;
+	initCompileWorkspace(&workspace);
 
-		//print postfix expression.
-		printf("%s", POSTFIX_TITLE);
-		printExpression(sizeOfPostfix, postfixExpression);
+	IntStack intStack;
+	IntStackInit(&intStack);
+
+	while (getline(&expression, &sizeOfLineBuffer, stdin) != -1)
+	{
+		CompiledExpression uncached = {NULL, NULL, NULL, 0};
+		const CompiledExpression *compiled = getCompiledExpression(&cache, &workspace, expression,
+																   &uncached);
+
+		//print infix and postfix expressions.
+		printf("%s%s%s", INFIX_TITLE, compiled->infixText, NEW_LINE);
+		printf("%s%s%s", POSTFIX_TITLE, compiled->postfixText, NEW_LINE);
 
 		//calculate mathematical value of the expression and print it.
-		calculateResultAndPrintIt(sizeOfPostfix, postfixExpression);
+		CalcInt result;
+		CalculationStatus status = calculateResult(compiled, &intStack, &result);
+		if(status != CALCULATION_SUCCESS)
+		{
+			fprintf(stderr, "%s", calculationErrorMessage(status));
+			exit(EXIT_FAILURE);
+		}
+		printf(PRINT_RESULT, result);
 
-		//free all allocated memory in the heap for both the infix and postfix expressions.
-		freeExpressions(sizeOfPostfix, postfixExpression, sizeOfInfix, infixExpression);
+		freeCompiledExpression(&uncached);
 	}
 
+	IntStackFree(&intStack);
+	freeCompileWorkspace(&workspace);
+	freeExpressionCache(&cache);
+	free(expression);
+
 	return 0;
 }
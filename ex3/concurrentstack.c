@@ -0,0 +1,251 @@
+#include "concurrentstack.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+#define EMPTY_INDEX 0
+#define INDEX_BITS 32
+#define INDEX_MASK 0xFFFFFFFFu
+#define ELIMINATION_SPINS 128
+#define RANDOM_MULTIPLIER 1103515245u
+#define RANDOM_INCREMENT 12345u
+
+// the seed of the choice of elimination slots of every thread
+static _Thread_local uint32_t gSlotSeed = 0;
+
+static uint32_t indexOf(uint64_t word)
+{
+  return (uint32_t)(word & INDEX_MASK);
+}
+
+// the word of a top or slot, which replaces old: the tag of old + 1, and index
+static uint64_t nextWord(uint64_t old, uint32_t index)
+{
+  return (((old >> INDEX_BITS) + 1) << INDEX_BITS) | index;
+}
+
+static char* dataOf(ConcurrentStack* stack, uint32_t index)
+{
+  return stack->_data + (size_t)(index - 1) * stack->_elementSize;
+}
+
+static void pushNode(ConcurrentStack* stack, _Atomic uint64_t* top, uint32_t index,
+		     uint64_t old)
+{
+  do
+    {
+      atomic_store_explicit(&stack->_next[index - 1], indexOf(old), memory_order_relaxed);
+    }
+  while (!atomic_compare_exchange_weak_explicit(top, &old, nextWord(old, index),
+						memory_order_release, memory_order_relaxed));
+}
+
+/*
+ * Pops a node of a stack (of the stack or of the free nodes), and returns its index, or
+ * EMPTY_INDEX if the stack is empty. The next of the top may be read after another thread popped
+ * it, but then the tag of the top has changed and the compare-and-swap fails.
+ */
+static uint32_t popNode(ConcurrentStack* stack, _Atomic uint64_t* top)
+{
+  uint64_t old = atomic_load_explicit(top, memory_order_acquire);
+  while (indexOf(old) != EMPTY_INDEX)
+    {
+      uint32_t next = atomic_load_explicit(&stack->_next[indexOf(old) - 1],
+					   memory_order_relaxed);
+      if (atomic_compare_exchange_weak_explicit(top, &old, nextWord(old, next),
+						memory_order_acquire, memory_order_acquire))
+	{
+	  return indexOf(old);
+	}
+    }
+  return EMPTY_INDEX;
+}
+
+static EliminationSlot* randomSlot(ConcurrentStack* stack)
+{
+  if (gSlotSeed == 0)
+    {
+      gSlotSeed = (uint32_t)(uintptr_t)&gSlotSeed | 1;
+    }
+  gSlotSeed = gSlotSeed * RANDOM_MULTIPLIER + RANDOM_INCREMENT;
+  return &stack->_elimination[(gSlotSeed >> 16) % ELIMINATION_ARRAY_SIZE];
+}
+
+/*
+ * Offers a node to a pop in the elimination array for a while. Returns 1 if a pop took it, and
+ * 0 if no pop came.
+ */
+static int offerNode(ConcurrentStack* stack, uint32_t index)
+{
+  EliminationSlot* slot = randomSlot(stack);
+  uint64_t empty = atomic_load_explicit(&slot->_offer, memory_order_relaxed);
+  if (indexOf(empty) != EMPTY_INDEX)
+    {
+      return 0;
+    }
+  uint64_t offer = nextWord(empty, index);
+  if (!atomic_compare_exchange_strong_explicit(&slot->_offer, &empty, offer,
+					       memory_order_release, memory_order_relaxed))
+    {
+      return 0;
+    }
+
+  int i;
+  for (i = 0; i < ELIMINATION_SPINS; i++)
+    {
+      if (atomic_load_explicit(&slot->_offer, memory_order_relaxed) != offer)
+	{
+	  return 1;
+	}
+    }
+  // withdraw the offer, unless a pop took it meanwhile
+  return !atomic_compare_exchange_strong_explicit(&slot->_offer, &offer,
+						  nextWord(offer, EMPTY_INDEX),
+						  memory_order_relaxed, memory_order_relaxed);
+}
+
+/*
+ * Takes a node which a push offers in the elimination array, if there's one in the slot it
+ * looks at. Returns its index, or EMPTY_INDEX.
+ */
+static uint32_t takeOfferedNode(ConcurrentStack* stack)
+{
+  EliminationSlot* slot = randomSlot(stack);
+  uint64_t offer = atomic_load_explicit(&slot->_offer, memory_order_relaxed);
+  if (indexOf(offer) == EMPTY_INDEX ||
+      !atomic_compare_exchange_strong_explicit(&slot->_offer, &offer,
+					       nextWord(offer, EMPTY_INDEX),
+					       memory_order_acquire, memory_order_relaxed))
+    {
+      return EMPTY_INDEX;
+    }
+  return indexOf(offer);
+}
+
+/*
+ * Allocates a stack of at most capacity elements (at least 1), elementSize bytes each (at least
+ * 1). Returns NULL if there's not enough memory.
+ */
+ConcurrentStack* concurrentStackAlloc(size_t elementSize, size_t capacity)
+{
+  if (capacity == 0 || elementSize == 0 || capacity >= INDEX_MASK ||
+      capacity > (size_t)-1 / elementSize)
+    {
+      return NULL;
+    }
+  size_t stackSize = (sizeof(ConcurrentStack) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE *
+    CACHE_LINE_SIZE;
+  ConcurrentStack* stack = (ConcurrentStack*)aligned_alloc(CACHE_LINE_SIZE, stackSize);
+  if (stack == NULL)
+    {
+      return NULL;
+    }
+  stack->_next = (_Atomic uint32_t*)malloc(capacity * sizeof(_Atomic uint32_t));
+  stack->_data = (char*)malloc(capacity * elementSize);
+  if (stack->_next == NULL || stack->_data == NULL)
+    {
+      free(stack->_next);
+      free(stack->_data);
+      free(stack);
+      return NULL;
+    }
+  stack->_capacity = capacity;
+  stack->_elementSize = elementSize;
+
+  atomic_init(&stack->_top, EMPTY_INDEX);
+  int i;
+  for (i = 0; i < ELIMINATION_ARRAY_SIZE; i++)
+    {
+      atomic_init(&stack->_elimination[i]._offer, EMPTY_INDEX);
+    }
+  // all the nodes are free: node i is followed by node i + 1
+  uint32_t index;
+  for (index = 1; index <= capacity; index++)
+    {
+      atomic_init(&stack->_next[index - 1], (index < capacity) ? index + 1 : EMPTY_INDEX);
+    }
+  atomic_init(&stack->_freeTop, 1);
+  return stack;
+}
+
+/*
+ * Frees the stack. No thread may use it anymore.
+ */
+void freeConcurrentStack(ConcurrentStack** stack)
+{
+  if (!(*stack == NULL))
+    {
+      free((*stack)->_next);
+      free((*stack)->_data);
+      free(*stack);
+      *stack = NULL;
+    }
+}
+
+/*
+ * Pushes a copy of data. Returns 1 on success, and 0 if the stack is full (all of its capacity
+ * is in use).
+ */
+int concurrentPush(ConcurrentStack* stack, const void *data)
+{
+  assert(stack != NULL);
+  uint32_t index = popNode(stack, &stack->_freeTop);
+  if (index == EMPTY_INDEX)
+    {
+      return 0;
+    }
+  memcpy(dataOf(stack, index), data, stack->_elementSize);
+
+  uint64_t old = atomic_load_explicit(&stack->_top, memory_order_relaxed);
+  while (1)
+    {
+      atomic_store_explicit(&stack->_next[index - 1], indexOf(old), memory_order_relaxed);
+      if (atomic_compare_exchange_weak_explicit(&stack->_top, &old, nextWord(old, index),
+						memory_order_release, memory_order_relaxed))
+	{
+	  return 1;
+	}
+      // the top is contended: meet a pop instead
+      if (offerNode(stack, index))
+	{
+	  return 1;
+	}
+      old = atomic_load_explicit(&stack->_top, memory_order_relaxed);
+    }
+}
+
+/*
+ * Pops the top element to headData. Returns 1 on success, and 0 if the stack is empty.
+ */
+int concurrentPop(ConcurrentStack* stack, void *headData)
+{
+  assert(stack != NULL);
+  uint32_t index = EMPTY_INDEX;
+  uint64_t old = atomic_load_explicit(&stack->_top, memory_order_acquire);
+  while (index == EMPTY_INDEX)
+    {
+      if (indexOf(old) == EMPTY_INDEX)
+	{
+	  return 0;
+	}
+      uint32_t next = atomic_load_explicit(&stack->_next[indexOf(old) - 1],
+					   memory_order_relaxed);
+      if (atomic_compare_exchange_weak_explicit(&stack->_top, &old, nextWord(old, next),
+						memory_order_acquire, memory_order_acquire))
+	{
+	  index = indexOf(old);
+	}
+      else
+	{
+	  // the top is contended: meet a push instead
+	  index = takeOfferedNode(stack);
+	  old = atomic_load_explicit(&stack->_top, memory_order_acquire);
+	}
+    }
+
+  memcpy(headData, dataOf(stack, index), stack->_elementSize);
+  pushNode(stack, &stack->_freeTop, index,
+	   atomic_load_explicit(&stack->_freeTop, memory_order_relaxed));
+  return 1;
+}
@@ -0,0 +1,50 @@
+#ifndef CONCURRENTSTACK_H
+#define CONCURRENTSTACK_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE_SIZE 64
+#define ELIMINATION_ARRAY_SIZE 8
+
+/*
+ * A slot of the elimination array, on its own cache line: the tag and the index + 1 of the node
+ * a push offers to a pop (0 if there's no offer).
+ */
+typedef struct EliminationSlot
+{
+  _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t _offer;
+} EliminationSlot;
+
+/*
+ * A lock-free stack (Treiber stack), which many threads can push to and pop from. Its nodes come
+ * from a pool of a fixed capacity, allocated with the stack, and popped nodes go back to the pool
+ * (which is a lock-free stack of free nodes), so push and pop never allocate.
+ *
+ * The tops of the stacks are a node index (+ 1, 0 is empty) and a tag in one 64 bit word, which
+ * is incremented on every change, so a compare-and-swap fails if the top was popped and pushed
+ * again in between (the ABA problem). A push or pop which fails a compare-and-swap tries to meet
+ * a pop or push of another thread in the elimination array, and if they meet they exchange the
+ * node without touching the top.
+ */
+typedef struct ConcurrentStack
+{
+  _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t _top;
+  _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t _freeTop;
+  EliminationSlot _elimination[ELIMINATION_ARRAY_SIZE];
+  _Atomic uint32_t * _next;  // the index + 1 of the next node of every node
+  char * _data;              // the data of every node, _elementSize bytes each
+  size_t _capacity;
+  size_t _elementSize;
+} ConcurrentStack;
+
+ConcurrentStack* concurrentStackAlloc(size_t elementSize, size_t capacity);
+
+void freeConcurrentStack(ConcurrentStack** stack);
+
+int concurrentPush(ConcurrentStack* stack, const void *data);
+
+int concurrentPop(ConcurrentStack* stack, void *headData);
+
+#endif
@@ -4,11 +4,55 @@
 #include <stdio.h>
 #include <assert.h>
 
-Stack* stackAlloc(size_t elementSize)
+#define INITIAL_CAPACITY 16
+#define GROWTH_FACTOR 2
+#define MAX_NODES_PER_CHUNK 4096
+
+/*
+ * A chunk of a pooled linked stack: the header is followed by its nodes, and then by the data of
+ * the nodes, _elementSize bytes each.
+ */
+typedef struct NodeChunk
+{
+  struct NodeChunk * _next;
+} NodeChunk;
+
+static Stack* allocStack(size_t elementSize, int isLinked)
 {
   Stack* stack = (Stack*)malloc(sizeof(Stack));
+  if (stack == NULL)
+    {
+      return NULL;
+    }
   stack->_top = NULL;
+  stack->_elements = NULL;
+  stack->_size = 0;
+  stack->_capacity = 0;
   stack->_elementSize = elementSize;
+  stack->_isLinked = isLinked;
+  stack->_chunks = NULL;
+  stack->_freeNodes = NULL;
+  stack->_nodesPerChunk = 0;
+  return stack;
+}
+
+Stack* stackAlloc(size_t elementSize)
+{
+  return allocStack(elementSize, 0);
+}
+
+Stack* linkedStackAlloc(size_t elementSize)
+{
+  return allocStack(elementSize, 1);
+}
+
+Stack* pooledLinkedStackAlloc(size_t elementSize)
+{
+  Stack* stack = allocStack(elementSize, 1);
+  if (stack != NULL)
+    {
+      stack->_nodesPerChunk = INITIAL_CAPACITY;
+    }
   return stack;
 }
 
@@ -16,49 +60,214 @@ void freeStack(Stack** stack)
 {
   Node* p1;
   Node* p2;
+  NodeChunk* chunk;
   if (!(*stack == NULL))
     {
-      p1= (*stack)->_top;
-      while(p1)
+      if ((*stack)->_nodesPerChunk > 0)
+	{
+	  // the nodes of a pooled stack are freed with their chunks
+	  while ((*stack)->_chunks)
+	    {
+	      chunk = (*stack)->_chunks;
+	      (*stack)->_chunks = chunk->_next;
+	      free(chunk);
+	    }
+	}
+      else
 	{
-	  p2= p1;
-	  p1= p1->_next;
-	  free(p2->_data);
-	  free(p2);
+	  p1= (*stack)->_top;
+	  while(p1)
+	    {
+	      p2= p1;
+	      p1= p1->_next;
+	      free(p2->_data);
+	      free(p2);
+	    }
 	}
+      free((*stack)->_elements);
       free(*stack);
       *stack = NULL;
     }
 }
 
-void push(Stack* stack, void *data)
+/*
+ * Makes room for at least capacity elements in an array backed stack, so pushing them doesn't
+ * allocate. Returns 1 on success (and always for a linked stack), and 0 if there's not enough
+ * memory.
+ */
+int reserve(Stack* stack, size_t capacity)
+{
+  assert(stack != NULL);
+  if (stack->_isLinked || capacity <= stack->_capacity)
+    {
+      return 1;
+    }
+  if (stack->_elementSize > 0 && capacity > (size_t)-1 / stack->_elementSize)
+    {
+      return 0;
+    }
+
+  char *elements = (char*)realloc(stack->_elements, capacity * stack->_elementSize);
+  if (elements == NULL)
+    {
+      return 0;
+    }
+  stack->_elements = elements;
+  stack->_capacity = capacity;
+  return 1;
+}
+
+/*
+ * Adds a chunk to a pooled linked stack, and puts its nodes on the free list. The chunks grow
+ * geometrically up to MAX_NODES_PER_CHUNK nodes. Returns 1 on success, and 0 if there's not
+ * enough memory.
+ */
+static int addNodeChunk(Stack* stack)
+{
+  size_t numOfNodes = stack->_nodesPerChunk;
+  size_t nodeSize = sizeof(Node) + stack->_elementSize;
+  if (numOfNodes > ((size_t)-1 - sizeof(NodeChunk)) / nodeSize)
+    {
+      return 0;
+    }
+  NodeChunk* chunk = (NodeChunk*)malloc(sizeof(NodeChunk) + numOfNodes * nodeSize);
+  if (chunk == NULL)
+    {
+      return 0;
+    }
+  chunk->_next = stack->_chunks;
+  stack->_chunks = chunk;
+
+  Node* nodes = (Node*)(chunk + 1);
+  char* data = (char*)(nodes + numOfNodes);
+  size_t i;
+  for (i = 0; i < numOfNodes; i++)
+    {
+      nodes[i]._data = data + i * stack->_elementSize;
+      nodes[i]._next = stack->_freeNodes;
+      stack->_freeNodes = &nodes[i];
+    }
+
+  if (stack->_nodesPerChunk < MAX_NODES_PER_CHUNK)
+    {
+      stack->_nodesPerChunk *= GROWTH_FACTOR;
+    }
+  return 1;
+}
+
+static void pushPooled(Stack* stack, void *data)
+{
+  if (stack->_freeNodes == NULL && !addNodeChunk(stack))
+    {
+      fprintf(stderr, "Not enough memory for the stack\n");
+      return;
+    }
+  Node* node = stack->_freeNodes;
+  stack->_freeNodes = node->_next;
+  memcpy(node->_data, data, stack->_elementSize);
+  node->_next = stack->_top;
+  stack->_top = node;
+}
+
+static void pushLinked(Stack* stack, void *data)
 {
-  //you should check allocation success
+  if (stack->_nodesPerChunk > 0)
+    {
+      pushPooled(stack, data);
+      return;
+    }
+
   Node* node = (Node*)malloc(sizeof(Node));
+  if (node == NULL)
+    {
+      fprintf(stderr, "Not enough memory for the stack\n");
+      return;
+    }
   node->_data = malloc(stack->_elementSize);
+  if (node->_data == NULL)
+    {
+      free(node);
+      fprintf(stderr, "Not enough memory for the stack\n");
+      return;
+    }
   memcpy(node->_data, data, stack->_elementSize);
   node->_next = stack->_top;
   stack->_top = node;
 }
 
+void push(Stack* stack, void *data)
+{
+  assert(stack != NULL);
+  if (stack->_isLinked)
+    {
+      pushLinked(stack, data);
+      return;
+    }
+
+  if (stack->_size == stack->_capacity &&
+      !reserve(stack, (stack->_capacity > 0) ? stack->_capacity * GROWTH_FACTOR :
+	       INITIAL_CAPACITY))
+    {
+      fprintf(stderr, "Not enough memory for the stack\n");
+      return;
+    }
+  memcpy(stack->_elements + stack->_size * stack->_elementSize, data, stack->_elementSize);
+  stack->_size++;
+}
+
 void pop(Stack* stack, void *headData) 
 {
   assert(stack != NULL);
-  if(stack->_top == NULL)
+  if(isEmptyStack(stack))
     {
       fprintf(stderr, "The stack is empty\n");
       return;
     }
 
+  if (!stack->_isLinked)
+    {
+      stack->_size--;
+      memcpy(headData, stack->_elements + stack->_size * stack->_elementSize,
+	     stack->_elementSize);
+      return;
+    }
+
   Node *node = stack->_top;
   memcpy(headData, node->_data,stack->_elementSize);
   stack->_top = node->_next;  
+  if (stack->_nodesPerChunk > 0)
+    {
+      node->_next = stack->_freeNodes;
+      stack->_freeNodes = node;
+      return;
+    }
   free(node->_data);
   free(node);
 }
 
+/*
+ * Copies the top element of the stack to headData, without popping it.
+ */
+void peek(Stack* stack, void *headData)
+{
+  assert(stack != NULL);
+  if(isEmptyStack(stack))
+    {
+      fprintf(stderr, "The stack is empty\n");
+      return;
+    }
+
+  if (!stack->_isLinked)
+    {
+      memcpy(headData, stack->_elements + (stack->_size - 1) * stack->_elementSize,
+	     stack->_elementSize);
+      return;
+    }
+  memcpy(headData, stack->_top->_data, stack->_elementSize);
+}
+
 int isEmptyStack(Stack* stack) 
 {
   assert(stack != NULL); 
-  return stack->_top == NULL; 
+  return stack->_isLinked ? stack->_top == NULL : stack->_size == 0;
 }
@@ -9,20 +9,45 @@ typedef struct Node
   struct Node * _next;
 } Node;
 
+struct NodeChunk;
+
+/*
+ * A stack is either array backed (stackAlloc): its elements are stored inline, one after the
+ * other, _elementSize bytes each, in one block which grows geometrically - or linked
+ * (linkedStackAlloc): every element is a Node with its own copy of the data. The nodes of a
+ * pooled linked stack (pooledLinkedStackAlloc) and their data are carved from chunks owned by
+ * the stack, and popped nodes are kept on a free list for the next pushes, so once the stack
+ * has reached its peak size, push and pop don't call malloc or free.
+ */
 typedef struct Stack
 {
-  Node * _top;
+  Node * _top;            // the top node of a linked stack
+  char * _elements;       // the elements of an array backed stack
+  size_t _size;           // the number of elements of an array backed stack
+  size_t _capacity;
   size_t _elementSize;    // we need that for memcpy
+  int _isLinked;
+  struct NodeChunk * _chunks;  // the chunks of a pooled linked stack
+  Node * _freeNodes;      // the popped nodes of a pooled linked stack
+  size_t _nodesPerChunk;  // the number of nodes of the next chunk
 } Stack;
 
 Stack* stackAlloc(size_t elementSize);
 
+Stack* linkedStackAlloc(size_t elementSize);
+
+Stack* pooledLinkedStackAlloc(size_t elementSize);
+
 void freeStack(Stack** stack);
 
+int reserve(Stack* stack, size_t capacity);
+
 void push(Stack* stack, void *data);
 
 void pop(Stack* stack,void *headData);
 
+void peek(Stack* stack, void *headData);
+
 int isEmptyStack(Stack* stack);
 
 #endif
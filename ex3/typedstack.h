@@ -0,0 +1,110 @@
+#ifndef TYPEDSTACK_H
+#define TYPEDSTACK_H
+
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * DEFINE_STACK(Name, T) defines a stack of T values named Name: an array of T, which grows
+ * geometrically, and static inline functions which push and pop by value (no memcpy, and no
+ * calls in the common case, so the compiler can keep the top of the stack in registers):
+ *
+ *   Name stack = {NULL, 0, 0};    (or NameInit(&stack))
+ *   NamePush(&stack, value)       returns 1, or 0 if there's not enough memory
+ *   NamePop(&stack)               returns the top value and removes it
+ *   NamePeek(&stack)              returns the top value
+ *   NameIsEmpty(&stack), NameClear(&stack), NameReserve(&stack, capacity), NameFree(&stack)
+ *
+ * Like pop of Stack, popping (or peeking) an empty stack prints an error, and returns a zero
+ * value.
+ */
+
+#define TYPED_STACK_INITIAL_CAPACITY 16
+#define TYPED_STACK_GROWTH_FACTOR 2
+
+#define DEFINE_STACK(Name, T)                                                                  \
+typedef struct Name                                                                            \
+{                                                                                              \
+  T * _elements;                                                                               \
+  size_t _size;                                                                                \
+  size_t _capacity;                                                                            \
+} Name;                                                                                        \
+                                                                                               \
+static inline void Name##Init(Name* stack)                                                     \
+{                                                                                              \
+  stack->_elements = NULL;                                                                     \
+  stack->_size = 0;                                                                            \
+  stack->_capacity = 0;                                                                        \
+}                                                                                              \
+                                                                                               \
+static inline void Name##Free(Name* stack)                                                     \
+{                                                                                              \
+  free(stack->_elements);                                                                      \
+  Name##Init(stack);                                                                           \
+}                                                                                              \
+                                                                                               \
+static inline int Name##Reserve(Name* stack, size_t capacity)                                  \
+{                                                                                              \
+  if (capacity <= stack->_capacity)                                                            \
+    {                                                                                          \
+      return 1;                                                                                \
+    }                                                                                          \
+  if (capacity > (size_t)-1 / sizeof(T))                                                       \
+    {                                                                                          \
+      return 0;                                                                                \
+    }                                                                                          \
+  T *elements = (T*)realloc(stack->_elements, capacity * sizeof(T));                          \
+  if (elements == NULL)                                                                        \
+    {                                                                                          \
+      return 0;                                                                                \
+    }                                                                                          \
+  stack->_elements = elements;                                                                 \
+  stack->_capacity = capacity;                                                                 \
+  return 1;                                                                                    \
+}                                                                                              \
+                                                                                               \
+static inline int Name##Push(Name* stack, T value)                                             \
+{                                                                                              \
+  if (stack->_size == stack->_capacity &&                                                      \
+      !Name##Reserve(stack, (stack->_capacity > 0) ?                                           \
+		     stack->_capacity * TYPED_STACK_GROWTH_FACTOR : TYPED_STACK_INITIAL_CAPACITY))     \
+    {                                                                                          \
+      return 0;                                                                                \
+    }                                                                                          \
+  stack->_elements[stack->_size] = value;                                                      \
+  stack->_size++;                                                                              \
+  return 1;                                                                                    \
+}                                                                                              \
+                                                                                               \
+static inline int Name##IsEmpty(const Name* stack)                                             \
+{                                                                                              \
+  return stack->_size == 0;                                                                    \
+}                                                                                              \
+                                                                                               \
+static inline void Name##Clear(Name* stack)                                                    \
+{                                                                                              \
+  stack->_size = 0;                                                                            \
+}                                                                                              \
+                                                                                               \
+static inline T Name##Peek(const Name* stack)                                                  \
+{                                                                                              \
+  if (stack->_size == 0)                                                                       \
+    {                                                                                          \
+      T zero = {0};                                                                            \
+      fprintf(stderr, "The stack is empty\n");                                                 \
+      return zero;                                                                             \
+    }                                                                                          \
+  return stack->_elements[stack->_size - 1];                                                   \
+}                                                                                              \
+                                                                                               \
+static inline T Name##Pop(Name* stack)                                                         \
+{                                                                                              \
+  T value = Name##Peek(stack);                                                                 \
+  if (stack->_size > 0)                                                                        \
+    {                                                                                          \
+      stack->_size--;                                                                          \
+    }                                                                                          \
+  return value;                                                                                \
+}
+
+#endif